@@ -773,12 +773,13 @@ AC_DEFUN([AX_C___ATTRIBUTE__], [
   AC_MSG_CHECKING(for __attribute__)
   AC_CACHE_VAL(ac_cv___attribute__, [
     AC_TRY_COMPILE(
-      [#include <stdlib.h>],
-      [static void foo(void) __attribute__ ((unused));
+      [#include <stdlib.h>
+      static void foo(void) __attribute__ ((unused));
       static void
       foo(void) {
           exit(1);
       }],
+      [],
       ac_cv___attribute__=yes,
       ac_cv___attribute__=no
     )])
@@ -29,23 +29,18 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <mpi.h>
 #include "gstdint.h"
 #include "bitmap.h"
+#include "bitmap_priv.h"
 #include "utility.h"
 
 #define BITS_PER_CHAR (8*SIZEOF_CHAR)
 
-struct _bitmap_t
-{
-  unsigned size;
-  uint32_t * buf;
-};
-
 
 static inline 
 unsigned 
 elems_from_map (const bitmap_t * bm)
 {
-  return bm->size / (sizeof (uint32_t) * BITS_PER_CHAR)
-    + (bm->size % (sizeof (uint32_t) * BITS_PER_CHAR) ? 1 : 0);
+  return bm->size / (sizeof (bitmap_word_t) * BITS_PER_CHAR)
+    + (bm->size % (sizeof (bitmap_word_t) * BITS_PER_CHAR) ? 1 : 0);
 }
 
 
@@ -53,8 +48,8 @@ static inline
 unsigned 
 elems_from_size (unsigned size)
 {
-  return size / (sizeof (uint32_t) * BITS_PER_CHAR)
-    + (size % (sizeof (uint32_t) * BITS_PER_CHAR) ? 1 : 0);
+  return size / (sizeof (bitmap_word_t) * BITS_PER_CHAR)
+    + (size % (sizeof (bitmap_word_t) * BITS_PER_CHAR) ? 1 : 0);
 }
 
 
@@ -62,7 +57,7 @@ static inline
 unsigned
 bytes_from_map (const bitmap_t * bm)
 {
-  return elems_from_map (bm) * sizeof (uint32_t);
+  return elems_from_map (bm) * sizeof (bitmap_word_t);
 }
 
 
@@ -70,7 +65,7 @@ static inline
 unsigned
 bytes_from_size (unsigned size)
 {
-  return elems_from_size (size) * sizeof (uint32_t);
+  return elems_from_size (size) * sizeof (bitmap_word_t);
 }
 
 
@@ -78,23 +73,23 @@ static inline
 unsigned
 index_for_pos (unsigned pos)
 {
-  return pos / (sizeof (uint32_t) * BITS_PER_CHAR);
+  return pos / (sizeof (bitmap_word_t) * BITS_PER_CHAR);
 }
 
 
 static inline
-uint32_t
+bitmap_word_t
 mask_for_pos (unsigned pos)
 {
-  return 1u << (pos % (sizeof (uint32_t) * BITS_PER_CHAR));
+  return (bitmap_word_t)1 << (pos % (sizeof (bitmap_word_t) * BITS_PER_CHAR));
 }
 
 
 static inline
-uint32_t
+bitmap_word_t
 mask_for_rem (unsigned rem)
 {
-  return 0xffffffffu >> (sizeof (uint32_t) * BITS_PER_CHAR - rem);
+  return ~(bitmap_word_t)0 >> (sizeof (bitmap_word_t) * BITS_PER_CHAR - rem);
 }
 
 
@@ -102,14 +97,14 @@ static inline
 unsigned
 rem_from_map (const bitmap_t * bm)
 {
-  return bm->size % (sizeof (uint32_t) * BITS_PER_CHAR);
+  return bm->size % (sizeof (bitmap_word_t) * BITS_PER_CHAR);
 }
 
 static inline
 unsigned
 rem_from_size (unsigned size)
 {
-  return size % (sizeof (uint32_t) * BITS_PER_CHAR);
+  return size % (sizeof (bitmap_word_t) * BITS_PER_CHAR);
 }
 
 /**
@@ -173,6 +168,40 @@ bitmap_destruct (bitmap_t * bm)
 }
 
 
+/**
+   Returns how many bytes bitmap_place() needs for bitmap of given size.
+   @param size number of bits
+   @return size of memory block in bytes
+*/
+size_t
+bitmap_footprint (unsigned size)
+{
+  return sizeof (bitmap_t) + bytes_from_size (size);
+}
+
+
+/**
+   Constructs bitmap and its storage in a single block of memory provided
+   by caller. The bits are not cleared. Such bitmap must not be passed to
+   bitmap_delete(), bitmap_destruct() or bitmap_resize().
+   @param mem block of at least bitmap_footprint(size) bytes aligned for
+   a pointer and bitmap_word_t
+   @param size number of bits
+   @return bitmap
+*/
+bitmap_t *
+bitmap_place (void * mem, unsigned size)
+{
+  bitmap_t * bm = mem;
+
+  if (size == 0)
+    abort ();
+  bm->buf = (bitmap_word_t *)(bm + 1);
+  bm->size = size;
+  return bm;
+}
+
+
 /**
    Frees memory allocated by bitmap.
    @param bm bitmap
@@ -213,6 +242,22 @@ bitmap_clone (const bitmap_t * bm)
 }
 
 
+/**
+   Copies bits of one bitmap into another bitmap of the same size.
+   @param dst destination bitmap
+   @param src source bitmap
+   @return destination bitmap
+*/
+bitmap_t *
+bitmap_copy (bitmap_t * dst, const bitmap_t * src)
+{
+  if (dst->size != src->size)
+    abort ();
+  memcpy (dst->buf, src->buf, bytes_from_map (src));
+  return dst;
+}
+
+
 /**
    Shrinks or enlarges bitmap.
    @param bm bitmap
@@ -224,7 +269,7 @@ bitmap_t * bitmap_resize (bitmap_t * bm, unsigned size)
   const unsigned oldsize = bm->size;
   const unsigned oldbytes = bytes_from_size (oldsize);
   const unsigned newbytes = bytes_from_size (size);
-  uint32_t * newbuf;
+  bitmap_word_t * newbuf;
 
   if (size == 0)
     abort ();
@@ -246,7 +291,7 @@ bitmap_t * bitmap_resize (bitmap_t * bm, unsigned size)
     {
       const unsigned oldelems = elems_from_size (oldsize);
       const unsigned dif = elems_from_size (size) - oldelems;
-      memset (newbuf + oldelems, 0, dif * sizeof (uint32_t));
+      memset (newbuf + oldelems, 0, dif * sizeof (bitmap_word_t));
     }
   /* Shrinked bitmap with less bytes allocated. */
   else if (newbytes < oldbytes)
@@ -254,7 +299,7 @@ bitmap_t * bitmap_resize (bitmap_t * bm, unsigned size)
       const unsigned dif = newbytes * BITS_PER_CHAR - size;
       if (dif != 0)
         {
-          const uint32_t mask = 0xffffffffu >> dif;
+          const bitmap_word_t mask = ~(bitmap_word_t)0 >> dif;
           newbuf[elems_from_size (size) - 1] &= mask;
         }
     }
@@ -273,7 +318,7 @@ bitmap_t * bitmap_resize (bitmap_t * bm, unsigned size)
         abort (); /* Already handled */
       if (dif != 0)
         {
-          const unsigned mask = 0xffffffffu >> dif;
+          const bitmap_word_t mask = ~(bitmap_word_t)0 >> dif;
           newbuf[elems_from_size (size) - 1] &= mask;
         }
     }
@@ -295,8 +340,8 @@ bitmap_getbit (const bitmap_t * bm, unsigned pos)
   if (pos < bm->size)
     {
       const unsigned i = index_for_pos (pos);
-      const uint32_t mask = mask_for_pos (pos);
-      uint32_t elem;
+      const bitmap_word_t mask = mask_for_pos (pos);
+      bitmap_word_t elem;
       
       elem = bm->buf[i];
       return elem & mask ? 1 : 0;
@@ -320,8 +365,8 @@ bitmap_putbit (const bitmap_t * bm, unsigned pos, int val)
   if (pos < bm->size)
     {
       const unsigned i = index_for_pos (pos);
-      const uint32_t mask = mask_for_pos (pos);
-      uint32_t elem;
+      const bitmap_word_t mask = mask_for_pos (pos);
+      bitmap_word_t elem;
       int prev;
       
       elem = bm->buf[i];
@@ -371,8 +416,8 @@ bitmap_setbit (const bitmap_t * bm, unsigned pos)
   if (pos < bm->size)
     {
       const unsigned i = index_for_pos (pos);
-      const uint32_t mask = mask_for_pos (pos);
-      uint32_t elem;
+      const bitmap_word_t mask = mask_for_pos (pos);
+      bitmap_word_t elem;
       int prev;
       
       elem = bm->buf[i];
@@ -397,8 +442,8 @@ bitmap_clrbit (const bitmap_t * bm, unsigned pos)
   if (pos < bm->size)
     {
       const unsigned i = index_for_pos (pos);
-      const uint32_t mask = mask_for_pos (pos);
-      uint32_t elem;
+      const bitmap_word_t mask = mask_for_pos (pos);
+      bitmap_word_t elem;
       int prev;
       
       elem = bm->buf[i];
@@ -435,12 +480,12 @@ bitmap_set (bitmap_t * bm)
 {
   const unsigned rem = rem_from_map (bm);
   const unsigned setsize = 
-    bytes_from_map (bm) - (rem ? sizeof (uint32_t) : 0);
+    bytes_from_map (bm) - (rem ? sizeof (bitmap_word_t) : 0);
   
   memset (bm->buf, 0xff, setsize);
   if (rem != 0)
     {
-      const unsigned mask = mask_for_rem (rem);
+      const bitmap_word_t mask = mask_for_rem (rem);
       bm->buf[elems_from_map (bm) - 1] |= mask;
     }
   return bm;
@@ -463,12 +508,250 @@ bitmap_flip (bitmap_t * bm)
     bm->buf[i] = ~bm->buf[i];
   if (rem != 0)
     {
-      const uint32_t mask = mask_for_rem (rem);
+      const bitmap_word_t mask = mask_for_rem (rem);
       bm->buf[i] = ~bm->buf[i] & mask;
     }
   return bm;
 }
 
+/**
+   Counts set bits of one word.
+*/
+static inline
+unsigned
+popcount_word (bitmap_word_t w)
+{
+#ifdef __GNUC__
+  return __builtin_popcountll (w);
+#else
+  unsigned count = 0;
+
+  for (; w; w &= w - 1)
+    ++count;
+  return count;
+#endif
+}
+
+
+/**
+   Returns position of the lowest set bit of non-zero word.
+*/
+static inline
+unsigned
+lowest_word_bit (bitmap_word_t w)
+{
+#ifdef __GNUC__
+  return __builtin_ctzll (w);
+#else
+  unsigned pos = 0;
+
+  while (! (w & 1))
+    {
+      w >>= 1;
+      ++pos;
+    }
+  return pos;
+#endif
+}
+
+
+/**
+   Intersects bitmap with another bitmap of the same size.
+   @param dst destination bitmap
+   @param src source bitmap
+   @return destination bitmap
+*/
+bitmap_t *
+bitmap_and (bitmap_t * dst, const bitmap_t * src)
+{
+  const unsigned elems = elems_from_map (dst);
+  unsigned i;
+
+  if (dst->size != src->size)
+    abort ();
+  for (i = 0; i < elems; ++i)
+    dst->buf[i] &= src->buf[i];
+  return dst;
+}
+
+
+/**
+   Unites bitmap with another bitmap of the same size.
+   @param dst destination bitmap
+   @param src source bitmap
+   @return destination bitmap
+*/
+bitmap_t *
+bitmap_or (bitmap_t * dst, const bitmap_t * src)
+{
+  const unsigned elems = elems_from_map (dst);
+  unsigned i;
+
+  if (dst->size != src->size)
+    abort ();
+  for (i = 0; i < elems; ++i)
+    dst->buf[i] |= src->buf[i];
+  return dst;
+}
+
+
+/**
+   Computes symmetric difference with another bitmap of the same size.
+   @param dst destination bitmap
+   @param src source bitmap
+   @return destination bitmap
+*/
+bitmap_t *
+bitmap_xor (bitmap_t * dst, const bitmap_t * src)
+{
+  const unsigned elems = elems_from_map (dst);
+  unsigned i;
+
+  if (dst->size != src->size)
+    abort ();
+  for (i = 0; i < elems; ++i)
+    dst->buf[i] ^= src->buf[i];
+  return dst;
+}
+
+
+/**
+   Clears bits of bitmap that are set in another bitmap of the same size.
+   @param dst destination bitmap
+   @param src source bitmap
+   @return destination bitmap
+*/
+bitmap_t *
+bitmap_andnot (bitmap_t * dst, const bitmap_t * src)
+{
+  const unsigned elems = elems_from_map (dst);
+  unsigned i;
+
+  if (dst->size != src->size)
+    abort ();
+  for (i = 0; i < elems; ++i)
+    dst->buf[i] &= ~src->buf[i];
+  return dst;
+}
+
+
+/**
+   Counts set bits.
+   @param bm bitmap
+   @return number of set bits
+*/
+unsigned
+bitmap_count (const bitmap_t * bm)
+{
+  const unsigned elems = elems_from_map (bm);
+  unsigned i, count = 0;
+
+  for (i = 0; i < elems; ++i)
+    count += popcount_word (bm->buf[i]);
+  return count;
+}
+
+
+/**
+   Counts bits set in both bitmaps of the same size.
+   @param a bitmap
+   @param b bitmap
+   @return number of bits of intersection
+*/
+unsigned
+bitmap_count_and (const bitmap_t * a, const bitmap_t * b)
+{
+  const unsigned elems = elems_from_map (a);
+  unsigned i, count = 0;
+
+  if (a->size != b->size)
+    abort ();
+  for (i = 0; i < elems; ++i)
+    count += popcount_word (a->buf[i] & b->buf[i]);
+  return count;
+}
+
+
+/**
+   Finds the first set bit.
+   @param bm bitmap
+   @return position of the first set bit or size of bitmap if there is
+   none
+*/
+unsigned
+bitmap_first (const bitmap_t * bm)
+{
+  return bitmap_next (bm, 0);
+}
+
+
+/**
+   Finds the first set bit at position pos or after it.
+   @param bm bitmap
+   @param pos position to start at
+   @return position of the set bit or size of bitmap if there is none
+*/
+unsigned
+bitmap_next (const bitmap_t * bm, unsigned pos)
+{
+  const unsigned elems = elems_from_map (bm);
+  unsigned i = index_for_pos (pos);
+  bitmap_word_t w;
+
+  if (pos >= bm->size)
+    return bm->size;
+  /* Drop bits before pos. */
+  w = bm->buf[i] & ~(mask_for_pos (pos) - 1);
+  while (! w)
+    {
+      if (++i == elems)
+        return bm->size;
+      w = bm->buf[i];
+    }
+  return i * BITMAP_WORD_BITS + lowest_word_bit (w);
+}
+
+
+/**
+   Starts iteration over set bits of bitmap in increasing order.
+   @param it iterator
+   @param bm bitmap
+*/
+void
+bitmap_iter_init (bitmap_iter_t * it, const bitmap_t * bm)
+{
+  it->buf = bm->buf;
+  it->words = elems_from_map (bm);
+  it->index = 0;
+  it->word = it->words ? bm->buf[0] : 0;
+}
+
+
+/**
+   Advances iterator to the next set bit.
+   @param it iterator
+   @param pos receives position of the set bit
+   @return true if there was a set bit, false at the end of bitmap
+*/
+int
+bitmap_iter_next (bitmap_iter_t * it, unsigned * pos)
+{
+  while (! it->word)
+    {
+      if (++it->index >= it->words)
+        {
+          it->index = it->words;
+          return 0;
+        }
+      it->word = it->buf[it->index];
+    }
+  *pos = it->index * BITMAP_WORD_BITS + lowest_word_bit (it->word);
+  /* Clear the lowest set bit. */
+  it->word &= it->word - 1;
+  return 1;
+}
+
+
 /**
    Return number of bits in bitmap.
    @param bm bitmap
@@ -482,6 +765,20 @@ bitmap_size (const bitmap_t * bm)
 }
 
 
+/**
+   Gives read only access to words backing the bitmap. Bit at position
+   pos is bit pos % BITMAP_WORD_BITS of word pos / BITMAP_WORD_BITS, bits
+   beyond size of bitmap are zero.
+   @param bm bitmap
+   @return array of words
+ */
+const bitmap_word_t *
+bitmap_words (const bitmap_t * bm)
+{
+  return bm->buf;
+}
+
+
 /**
    Prints bitmap to a stream.
    @param bm bitmap
@@ -516,7 +813,7 @@ bitmap_print (const bitmap_t * bm, FILE * stream, const char * sep)
 size_t 
 bitmap_serialize_size (const bitmap_t * bm)
 {
-  return sizeof (unsigned) + elems_from_map (bm) * sizeof (uint32_t);
+  return sizeof (unsigned) + elems_from_map (bm) * sizeof (bitmap_word_t);
 }
 
 
@@ -527,14 +824,18 @@ void
 bitmap_serialize (void * buf, size_t size, size_t * pos, bitmap_t * bm)
 {
   int ret;
+  /* MPI keeps positions in int. */
+  int ipos = *pos;
   
-  ret = MPI_Pack (&bm->size, 1, MPI_UNSIGNED, buf, size, pos, MPI_COMM_WORLD);
+  ret = MPI_Pack (&bm->size, 1, MPI_UNSIGNED, buf, size, &ipos,
+                  MPI_COMM_WORLD);
   if (ret != MPI_SUCCESS)
     mpierror (ret, "MPI_Pack");
-  ret = MPI_Pack (bm->buf, elems_from_map(bm), MPI_UNSIGNED, buf, size, pos,
-                  MPI_COMM_WORLD);
+  ret = MPI_Pack (bm->buf, elems_from_map(bm), MPI_UINT64_T, buf, size,
+                  &ipos, MPI_COMM_WORLD);
   if (ret != MPI_SUCCESS)
     mpierror (ret, "MPI_Pack");
+  *pos = ipos;
 }
 
 
@@ -547,8 +848,11 @@ bitmap_deserialize (void * buf, size_t insize, size_t * pos)
   bitmap_t * bm;
   unsigned elems;
   int ret;
+  /* MPI keeps positions in int. */
+  int ipos = *pos;
 
-  ret = MPI_Unpack (buf, insize, pos, &elems, 1, MPI_UNSIGNED, MPI_COMM_WORLD);
+  ret = MPI_Unpack (buf, insize, &ipos, &elems, 1, MPI_UNSIGNED,
+                    MPI_COMM_WORLD);
   
   if (ret != MPI_SUCCESS)
     mpierror (ret, "MPI_Unpack()");
@@ -557,16 +861,48 @@ bitmap_deserialize (void * buf, size_t insize, size_t * pos)
     return NULL;
   bm->size = elems;
   elems = elems_from_size (elems);
-  bm->buf = malloc (elems * sizeof (uint32_t));
+  bm->buf = malloc (elems * sizeof (bitmap_word_t));
   if (! bm->buf)
     {
       free (bm);
       return NULL;
     }
-  ret = MPI_Unpack (buf, insize, pos, bm->buf, elems, MPI_UNSIGNED,
+  ret = MPI_Unpack (buf, insize, &ipos, bm->buf, elems, MPI_UINT64_T,
                     MPI_COMM_WORLD);
   if (ret != MPI_SUCCESS)
     mpierror (ret, "MPI_Unpack()");
+  *pos = ipos;
   
   return bm;
 }
+
+
+/**
+   Reconstructs serialized representation into an existing bitmap of the
+   same size.
+   @param bm bitmap
+   @return first parameter
+*/
+bitmap_t *
+bitmap_deserialize_into (bitmap_t * bm, void * buf, size_t insize,
+                         size_t * pos)
+{
+  unsigned size;
+  int ret;
+  /* MPI keeps positions in int. */
+  int ipos = *pos;
+
+  ret = MPI_Unpack (buf, insize, &ipos, &size, 1, MPI_UNSIGNED,
+                    MPI_COMM_WORLD);
+  if (ret != MPI_SUCCESS)
+    mpierror (ret, "MPI_Unpack()");
+  if (size != bm->size)
+    abort ();
+  ret = MPI_Unpack (buf, insize, &ipos, bm->buf, elems_from_map (bm),
+                    MPI_UINT64_T, MPI_COMM_WORLD);
+  if (ret != MPI_SUCCESS)
+    mpierror (ret, "MPI_Unpack()");
+  *pos = ipos;
+
+  return bm;
+}
@@ -29,6 +29,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <stdio.h>
 #include "config.h"
+#include "gstdint.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -40,12 +41,33 @@ extern "C" {
   */
   typedef struct _bitmap_t bitmap_t;
 
+  /* Word of storage of bitmap. */
+  typedef uint64_t bitmap_word_t;
+#define BITMAP_WORD_BITS 64
+
+  /**
+     Iterator over set bits of bitmap, see bitmap_iter_init(). The
+     bitmap must not be changed while iterating.
+  */
+  struct _bitmap_iter_t
+  {
+    const bitmap_word_t * buf;
+    unsigned words;
+    unsigned index;
+    /* Bits of buf[index] not visited yet. */
+    bitmap_word_t word;
+  };
+  typedef struct _bitmap_iter_t bitmap_iter_t;
+
   /* Interface for bitmap_t. */
   extern bitmap_t * bitmap_new (unsigned size);
   extern bitmap_t * bitmap_init (bitmap_t * bm, unsigned size);
   extern void bitmap_delete (bitmap_t * bm);
   extern void bitmap_destruct (bitmap_t * bm);
+  extern size_t bitmap_footprint (unsigned size);
+  extern bitmap_t * bitmap_place (void * mem, unsigned size);
   extern bitmap_t * bitmap_clone (const bitmap_t * bm);
+  extern bitmap_t * bitmap_copy (bitmap_t * dst, const bitmap_t * src);
   extern bitmap_t * bitmap_resize (bitmap_t * bm, unsigned size);
   extern int bitmap_setbit (const bitmap_t * bm, unsigned pos);
   extern int bitmap_clrbit (const bitmap_t * bm, unsigned pos);
@@ -55,13 +77,26 @@ extern "C" {
   extern bitmap_t * bitmap_clear (bitmap_t * bm);
   extern bitmap_t * bitmap_set (bitmap_t * bm);
   extern bitmap_t * bitmap_flip (bitmap_t * bm);
+  extern bitmap_t * bitmap_and (bitmap_t * dst, const bitmap_t * src);
+  extern bitmap_t * bitmap_or (bitmap_t * dst, const bitmap_t * src);
+  extern bitmap_t * bitmap_xor (bitmap_t * dst, const bitmap_t * src);
+  extern bitmap_t * bitmap_andnot (bitmap_t * dst, const bitmap_t * src);
+  extern unsigned bitmap_count (const bitmap_t * bm);
+  extern unsigned bitmap_count_and (const bitmap_t * a, const bitmap_t * b);
+  extern unsigned bitmap_first (const bitmap_t * bm);
+  extern unsigned bitmap_next (const bitmap_t * bm, unsigned pos);
+  extern void bitmap_iter_init (bitmap_iter_t * it, const bitmap_t * bm);
+  extern int bitmap_iter_next (bitmap_iter_t * it, unsigned * pos);
   extern unsigned bitmap_size (const bitmap_t * bm);
+  extern const bitmap_word_t * bitmap_words (const bitmap_t * bm);
   extern int bitmap_print (const bitmap_t * bm, FILE * stream, 
                            const char * sep);
   extern size_t bitmap_serialize_size (const bitmap_t * bm);
   extern void bitmap_serialize (void * buf, size_t size, size_t * pos, 
                                 bitmap_t * bm);
   extern bitmap_t * bitmap_deserialize (void * buf, size_t insize, size_t * pos);
+  extern bitmap_t * bitmap_deserialize_into (bitmap_t * bm, void * buf,
+                                             size_t insize, size_t * pos);
   
   
 #ifdef __cplusplus
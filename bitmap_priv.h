@@ -0,0 +1,102 @@
+/*
+Copyright (c) 1997-2007, Václav Haisman
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef _BITMAP_PRIV_H_
+#define _BITMAP_PRIV_H_
+
+/* Representation of bitmap_t and unchecked inline accessors for hot
+   loops. Positions are checked only when CHECKED_ACCESS is defined. */
+
+#include <stdlib.h>
+#include "config.h"
+#include "bitmap.h"
+
+#ifdef CHECKED_ACCESS
+# define BITMAP_CHECK(cond) do { if (! (cond)) abort (); } while (0)
+#else
+# define BITMAP_CHECK(cond) ((void)0)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  struct _bitmap_t
+  {
+    unsigned size;
+    bitmap_word_t * buf;
+  };
+
+
+  static inline
+  int
+  bitmap_getbit_fast (const bitmap_t * bm, unsigned pos)
+  {
+    BITMAP_CHECK (pos < bm->size);
+    return (bm->buf[pos / BITMAP_WORD_BITS] >> (pos % BITMAP_WORD_BITS)) & 1;
+  }
+
+
+  static inline
+  void
+  bitmap_setbit_fast (const bitmap_t * bm, unsigned pos)
+  {
+    BITMAP_CHECK (pos < bm->size);
+    bm->buf[pos / BITMAP_WORD_BITS]
+      |= (bitmap_word_t)1 << (pos % BITMAP_WORD_BITS);
+  }
+
+
+  static inline
+  void
+  bitmap_clrbit_fast (const bitmap_t * bm, unsigned pos)
+  {
+    BITMAP_CHECK (pos < bm->size);
+    bm->buf[pos / BITMAP_WORD_BITS]
+      &= ~((bitmap_word_t)1 << (pos % BITMAP_WORD_BITS));
+  }
+
+
+  /**
+     Flips bit and returns its previous value.
+  */
+  static inline
+  int
+  bitmap_flipbit_fast (const bitmap_t * bm, unsigned pos)
+  {
+    bitmap_word_t * const w = bm->buf + pos / BITMAP_WORD_BITS;
+    const bitmap_word_t mask = (bitmap_word_t)1 << (pos % BITMAP_WORD_BITS);
+
+    BITMAP_CHECK (pos < bm->size);
+    *w ^= mask;
+    return (*w & mask) == 0;
+  }
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif
@@ -0,0 +1,255 @@
+/*
+Copyright (c) 1997-2007, Václav Haisman
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <stdlib.h>
+#include <limits.h>
+#include "cgraph.h"
+#include "cgraph_priv.h"
+
+
+/* No group. */
+#define CGRAPH_NONE UINT_MAX
+
+
+/**
+   Frees memory allocated by graph.
+   @param g graph
+*/
+void
+cgraph_delete (cgraph_t * g)
+{
+  free (g->start);
+  free (g->nbr);
+  free (g->wt);
+  free (g->deg);
+  free (g);
+}
+
+
+static
+cgraph_t *
+cgraph_alloc (unsigned n, size_t arcs)
+{
+  cgraph_t * g;
+
+  g = malloc (sizeof (cgraph_t));
+  if (! g)
+    return NULL;
+  g->n = n;
+  g->start = malloc ((n + 1) * sizeof (size_t));
+  g->nbr = malloc ((arcs ? arcs : 1) * sizeof (unsigned));
+  g->wt = malloc ((arcs ? arcs : 1) * sizeof (long long));
+  g->deg = malloc ((n ? n : 1) * sizeof (long long));
+  if (! g->start || ! g->nbr || ! g->wt || ! g->deg)
+    {
+      cgraph_delete (g);
+      return NULL;
+    }
+  return g;
+}
+
+
+/**
+   Returns number of nodes of graph.
+   @param g graph
+   @return number of nodes
+*/
+unsigned
+cgraph_nodes (const cgraph_t * g)
+{
+  return g->n;
+}
+
+
+/**
+   Returns number of edges of graph.
+   @param g graph
+   @return number of edges
+*/
+size_t
+cgraph_edges (const cgraph_t * g)
+{
+  return g->start[g->n] / 2;
+}
+
+
+/**
+   Copies graph, node x becomes node x-1. Edges of zero weight are
+   left out.
+   @param csr graph
+   @return new graph or NULL on allocation failure
+*/
+cgraph_t *
+cgraph_from_csr (const csr_t * csr)
+{
+  const unsigned n = csr_nodes (csr);
+  const unsigned * nbr;
+  const int * wt;
+  cgraph_t * g;
+  unsigned x, i, deg;
+  size_t k = 0;
+
+  g = cgraph_alloc (n, 2 * csr_edges (csr));
+  if (! g)
+    return NULL;
+  for (x = 0; x < n; ++x)
+    {
+      deg = csr_row (csr, x + 1, &nbr, &wt);
+      g->start[x] = k;
+      g->deg[x] = 0;
+      for (i = 0; i < deg; ++i)
+        if (wt[i] > 0)
+          {
+            g->nbr[k] = nbr[i] - 1;
+            g->wt[k++] = wt[i];
+            g->deg[x] += wt[i];
+          }
+    }
+  g->start[n] = k;
+  return g;
+}
+
+
+/**
+   Contracts groups of nodes of graph into single nodes in O(n + m).
+   Edges inside groups are dropped, edges between two groups are
+   merged.
+   @param g graph
+   @param to to[v] is the group of node v
+   @param k number of groups
+   @return new graph of k nodes or NULL on allocation failure
+*/
+cgraph_t *
+cgraph_contract (const cgraph_t * g, const unsigned * to, unsigned k)
+{
+  cgraph_t * h;
+  size_t * first, * slot, pos = 0, i;
+  unsigned * member, * mark;
+  unsigned c, v, d;
+
+  h = cgraph_alloc (k, g->start[g->n]);
+  first = calloc (k + 1, sizeof (size_t));
+  slot = malloc (k * sizeof (size_t));
+  member = malloc (g->n * sizeof (unsigned));
+  mark = malloc (k * sizeof (unsigned));
+  if (! h || ! first || ! slot || ! member || ! mark)
+    {
+      if (h)
+        cgraph_delete (h);
+      free (first);
+      free (slot);
+      free (member);
+      free (mark);
+      return NULL;
+    }
+  /* List members of groups by counting sort. */
+  for (v = 0; v < g->n; ++v)
+    ++first[to[v]+1];
+  for (c = 0; c < k; ++c)
+    {
+      first[c+1] += first[c];
+      slot[c] = first[c];
+      mark[c] = CGRAPH_NONE;
+    }
+  for (v = 0; v < g->n; ++v)
+    member[slot[to[v]]++] = v;
+  /* Rows of groups, mark and slot tell where each neighbouring group
+     is in the row being built. */
+  for (c = 0; c < k; ++c)
+    {
+      h->start[c] = pos;
+      h->deg[c] = 0;
+      for (i = first[c]; i < first[c+1]; ++i)
+        {
+          size_t a;
+
+          v = member[i];
+          for (a = g->start[v]; a < g->start[v+1]; ++a)
+            {
+              d = to[g->nbr[a]];
+              if (d == c)
+                continue;
+              if (mark[d] == c)
+                h->wt[slot[d]] += g->wt[a];
+              else
+                {
+                  mark[d] = c;
+                  slot[d] = pos;
+                  h->nbr[pos] = d;
+                  h->wt[pos++] = g->wt[a];
+                }
+              h->deg[c] += g->wt[a];
+            }
+        }
+    }
+  h->start[k] = pos;
+  free (first);
+  free (slot);
+  free (member);
+  free (mark);
+  return h;
+}
+
+
+/**
+   Copies graph into CSR format, node v becomes node v+1. Weights of
+   edges have to fit into int.
+   @param g graph
+   @return new graph or NULL on allocation failure
+*/
+csr_t *
+cgraph_to_csr (const cgraph_t * g)
+{
+  csr_t * csr;
+  unsigned * ends;
+  int * wt;
+  size_t m = 0, a;
+  unsigned v;
+
+  ends = malloc ((g->start[g->n] ? g->start[g->n] : 1) * sizeof (unsigned));
+  wt = malloc ((g->start[g->n] ? g->start[g->n] : 1) * sizeof (int));
+  if (! ends || ! wt)
+    {
+      free (ends);
+      free (wt);
+      return NULL;
+    }
+  /* Each edge is taken once, from its lower end. */
+  for (v = 0; v < g->n; ++v)
+    for (a = g->start[v]; a < g->start[v+1]; ++a)
+      if (g->nbr[a] > v)
+        {
+          if (g->wt[a] > INT_MAX)
+            abort ();
+          ends[2*m] = v + 1;
+          ends[2*m+1] = g->nbr[a] + 1;
+          wt[m++] = (int) g->wt[a];
+        }
+  csr = csr_from_edges (g->n, m, ends, wt);
+  free (ends);
+  free (wt);
+  return csr;
+}
@@ -0,0 +1,57 @@
+/*
+Copyright (c) 1997-2007, Václav Haisman
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef _CGRAPH_H_
+#define _CGRAPH_H_
+
+#include "config.h"
+#include "csr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /**
+     Graph being contracted by minimum cut algorithms. Weights are long
+     long so that merged edges and degrees of contracted nodes do not
+     overflow.
+  */
+  struct _cgraph_t;
+  typedef struct _cgraph_t cgraph_t;
+
+  extern cgraph_t * cgraph_from_csr (const csr_t * csr);
+  extern cgraph_t * cgraph_contract (const cgraph_t * g, const unsigned * to,
+                                     unsigned k);
+  extern csr_t * cgraph_to_csr (const cgraph_t * g);
+  extern void cgraph_delete (cgraph_t * g);
+  extern unsigned cgraph_nodes (const cgraph_t * g);
+  extern size_t cgraph_edges (const cgraph_t * g);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
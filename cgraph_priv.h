@@ -0,0 +1,58 @@
+/*
+Copyright (c) 1997-2007, Václav Haisman
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef _CGRAPH_PRIV_H_
+#define _CGRAPH_PRIV_H_
+
+/* Representation of cgraph_t, engines read rows directly in their
+   hot loops. */
+
+#include <stddef.h>
+#include "config.h"
+#include "cgraph.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /* Nodes are counted from 0. Neighbours of a node are not sorted,
+     parallel edges are merged. Arcs of node v are start[v] ...
+     start[v+1]-1. */
+  struct _cgraph_t
+  {
+    unsigned n;
+    size_t * start;
+    unsigned * nbr;
+    long long * wt;
+    /* Weighted degrees of nodes. */
+    long long * deg;
+  };
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,322 @@
+/*
+Copyright (c) 1997-2007, Václav Haisman
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "csr.h"
+
+
+struct _csr_t
+{
+  /* Number of nodes. */
+  unsigned n;
+  /* Neighbours of node x are nbr[start[x-1]] ... nbr[start[x]-1]. */
+  size_t * start;
+  unsigned * nbr;
+  int * wt;
+};
+
+
+/**
+   Builds sparse representation of graph given by adjacency and weight
+   matrices.
+   @param graph adjacency matrix
+   @param weights weights of edges
+   @param n number of nodes
+   @return new graph or NULL on allocation failure
+*/
+csr_t *
+csr_new (const trimatrix_t * graph, const wtrimatrix_t * weights, unsigned n)
+{
+  csr_t * g;
+  size_t count = 0;
+  unsigned x, y;
+
+  if (n == 0)
+    abort ();
+  g = malloc (sizeof (csr_t));
+  if (! g)
+    return NULL;
+  g->n = n;
+  g->start = malloc ((n + 1) * sizeof (size_t));
+  if (! g->start)
+    {
+      free (g);
+      return NULL;
+    }
+  /* Count neighbours of each node. */
+  g->start[0] = 0;
+  for (x = 1; x <= n; ++x)
+    {
+      for (y = 1; y <= n; ++y)
+        if (y != x && trimatrix_get (graph, x, y))
+          ++count;
+      g->start[x] = count;
+    }
+  g->nbr = malloc ((count ? count : 1) * sizeof (unsigned));
+  g->wt = malloc ((count ? count : 1) * sizeof (int));
+  if (! g->nbr || ! g->wt)
+    {
+      free (g->nbr);
+      free (g->wt);
+      free (g->start);
+      free (g);
+      return NULL;
+    }
+  /* Fill them in. */
+  count = 0;
+  for (x = 1; x <= n; ++x)
+    for (y = 1; y <= n; ++y)
+      if (y != x && trimatrix_get (graph, x, y))
+        {
+          g->nbr[count] = y;
+          g->wt[count] = wtrimatrix_get (weights, x, y);
+          ++count;
+        }
+  return g;
+}
+
+
+/**
+   Builds sparse representation of graph given by list of its edges in
+   O(n + m) time and memory. Edges are undirected, loops are skipped
+   and weights of parallel edges are summed.
+   @param n number of nodes
+   @param m number of edges
+   @param ends end nodes of edges, edge i joins ends[2*i] and ends[2*i+1]
+   @param wt weights of edges
+   @return new graph or NULL on allocation failure
+*/
+csr_t *
+csr_from_edges (unsigned n, size_t m, const unsigned * ends, const int * wt)
+{
+  csr_t * g;
+  size_t * fill;
+  unsigned * tmpnbr;
+  int * tmpwt;
+  size_t i, k, w, begin;
+  unsigned x, y;
+
+  if (n == 0)
+    abort ();
+  for (i = 0; i < 2 * m; ++i)
+    if (ends[i] == 0 || ends[i] > n)
+      abort ();
+  g = malloc (sizeof (csr_t));
+  if (! g)
+    return NULL;
+  g->n = n;
+  g->start = calloc (n + 1, sizeof (size_t));
+  fill = malloc ((n + 1) * sizeof (size_t));
+  tmpnbr = malloc ((m ? 2 * m : 1) * sizeof (unsigned));
+  tmpwt = malloc ((m ? 2 * m : 1) * sizeof (int));
+  g->nbr = malloc ((m ? 2 * m : 1) * sizeof (unsigned));
+  g->wt = malloc ((m ? 2 * m : 1) * sizeof (int));
+  if (! g->start || ! fill || ! tmpnbr || ! tmpwt || ! g->nbr || ! g->wt)
+    {
+      free (fill);
+      free (tmpnbr);
+      free (tmpwt);
+      csr_delete (g);
+      return NULL;
+    }
+  /* Count neighbours of each node. */
+  for (i = 0; i < m; ++i)
+    if (ends[2*i] != ends[2*i+1])
+      {
+        ++g->start[ends[2*i]];
+        ++g->start[ends[2*i+1]];
+      }
+  for (x = 1; x <= n; ++x)
+    g->start[x] += g->start[x-1];
+  /* Distribute arcs by their heads first and then stably by their
+     tails, so that rows come out sorted without comparisons. */
+  memcpy (fill, g->start, (n + 1) * sizeof (size_t));
+  for (i = 0; i < m; ++i)
+    {
+      x = ends[2*i];
+      y = ends[2*i+1];
+      if (x == y)
+        continue;
+      tmpnbr[fill[y-1]] = x;
+      tmpwt[fill[y-1]++] = wt[i];
+      tmpnbr[fill[x-1]] = y;
+      tmpwt[fill[x-1]++] = wt[i];
+    }
+  memcpy (fill, g->start, (n + 1) * sizeof (size_t));
+  for (y = 1; y <= n; ++y)
+    for (k = g->start[y-1]; k < g->start[y]; ++k)
+      {
+        x = tmpnbr[k];
+        g->nbr[fill[x-1]] = y;
+        g->wt[fill[x-1]++] = tmpwt[k];
+      }
+  free (fill);
+  free (tmpnbr);
+  free (tmpwt);
+  /* Merge parallel edges, they are adjacent in sorted rows. */
+  w = 0;
+  begin = 0;
+  for (x = 1; x <= n; ++x)
+    {
+      const size_t end = g->start[x];
+
+      g->start[x-1] = w;
+      for (k = begin; k < end; ++k)
+        if (w > g->start[x-1] && g->nbr[w-1] == g->nbr[k])
+          g->wt[w-1] += g->wt[k];
+        else
+          {
+            g->nbr[w] = g->nbr[k];
+            g->wt[w++] = g->wt[k];
+          }
+      begin = end;
+    }
+  g->start[n] = w;
+  return g;
+}
+
+
+/**
+   Fills adjacency and weight matrices from sparse representation of
+   graph.
+   @param g graph
+   @param graph new adjacency matrix of csr_nodes(g) nodes
+   @param weights weights of edges, they are widened as needed
+   @return true on success, false on allocation failure
+*/
+int
+csr_to_matrices (const csr_t * g, trimatrix_t * graph, wtrimatrix_t * weights)
+{
+  size_t k;
+  unsigned x;
+
+  for (x = 1; x <= g->n; ++x)
+    for (k = g->start[x-1]; k < g->start[x]; ++k)
+      {
+        if (! wtrimatrix_fit (weights, (wvalue_t)g->wt[k]))
+          return 0;
+        trimatrix_set (graph, x, g->nbr[k], 1);
+        wtrimatrix_set (weights, x, g->nbr[k], (wvalue_t)g->wt[k]);
+      }
+  return 1;
+}
+
+
+/**
+   Makes copy of graph with relabelled nodes.
+   @param g graph
+   @param pos pos[x-1] is the new label of node x
+   @return new graph or NULL on allocation failure
+*/
+csr_t *
+csr_permute (const csr_t * g, const unsigned * pos)
+{
+  csr_t * newg;
+  unsigned * ends;
+  int * wt;
+  size_t m = 0, k;
+  unsigned x;
+
+  ends = malloc ((g->start[g->n] ? g->start[g->n] : 1) * sizeof (unsigned));
+  wt = malloc ((g->start[g->n] ? g->start[g->n] : 1) * sizeof (int));
+  if (! ends || ! wt)
+    {
+      free (ends);
+      free (wt);
+      return NULL;
+    }
+  /* Each edge is taken once, from its lower end. */
+  for (x = 1; x <= g->n; ++x)
+    for (k = g->start[x-1]; k < g->start[x]; ++k)
+      if (g->nbr[k] > x)
+        {
+          ends[2*m] = pos[x-1];
+          ends[2*m+1] = pos[g->nbr[k]-1];
+          wt[m++] = g->wt[k];
+        }
+  newg = csr_from_edges (g->n, m, ends, wt);
+  free (ends);
+  free (wt);
+  return newg;
+}
+
+
+/**
+   Frees memory allocated by graph.
+   @param g graph
+*/
+void
+csr_delete (csr_t * g)
+{
+  free (g->nbr);
+  free (g->wt);
+  free (g->start);
+  free (g);
+}
+
+
+/**
+   Returns number of nodes of graph.
+   @param g graph
+   @return number of nodes
+*/
+unsigned
+csr_nodes (const csr_t * g)
+{
+  return g->n;
+}
+
+
+/**
+   Returns number of edges of graph.
+   @param g graph
+   @return number of edges
+*/
+size_t
+csr_edges (const csr_t * g)
+{
+  return g->start[g->n] / 2;
+}
+
+
+/**
+   Gives access to neighbours of a node.
+   @param g graph
+   @param x node
+   @param nbr pointer to array of neighbours of x
+   @param wt pointer to array of weights of edges to the neighbours
+   @return number of neighbours of x
+*/
+unsigned
+csr_row (const csr_t * g, unsigned x, const unsigned ** nbr, const int ** wt)
+{
+  if (x > g->n || x == 0)
+    abort ();
+  *nbr = g->nbr + g->start[x-1];
+  *wt = g->wt + g->start[x-1];
+  return (unsigned)(g->start[x] - g->start[x-1]);
+}
@@ -0,0 +1,64 @@
+/*
+Copyright (c) 1997-2007, Václav Haisman
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef _CSR_H_
+#define _CSR_H_
+
+#include "config.h"
+#include "matrix.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /**
+     Graph in compressed sparse row format. Neighbours of each node and
+     weights of the respective edges are stored in two contiguous
+     arrays, neighbours of one node in ascending order. Offsets into
+     the arrays are size_t, memory is O(nodes + edges). Nodes are
+     counted from 1.
+  */
+  struct _csr_t;
+  typedef struct _csr_t csr_t;
+
+  extern csr_t * csr_new (const trimatrix_t * graph, 
+                          const wtrimatrix_t * weights, unsigned n);
+  extern csr_t * csr_from_edges (unsigned n, size_t m, const unsigned * ends,
+                                 const int * wt);
+  extern int csr_to_matrices (const csr_t * g, trimatrix_t * graph,
+                              wtrimatrix_t * weights);
+  extern csr_t * csr_permute (const csr_t * g, const unsigned * pos);
+  extern void csr_delete (csr_t * g);
+  extern unsigned csr_nodes (const csr_t * g);
+  extern size_t csr_edges (const csr_t * g);
+  extern unsigned csr_row (const csr_t * g, unsigned x, 
+                           const unsigned ** nbr, const int ** wt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
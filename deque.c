@@ -0,0 +1,275 @@
+/*
+Copyright (c) 1997-2007, Václav Haisman
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "deque.h"
+
+/* Initial capacity of deque, must be a power of 2. */
+#define DEQUE_INITIAL 64
+
+
+struct _deque_t
+{
+  /* Capacity of buf, always a power of 2. */
+  unsigned cap;
+  /* Index of the bottom element. */
+  unsigned head;
+  unsigned count;
+  void ** buf;
+};
+
+
+/**
+   Returns index of i-th element counted from bottom.
+*/
+static inline
+unsigned
+slot (const deque_t * d, unsigned i)
+{
+  return (d->head + i) & (d->cap - 1);
+}
+
+
+/**
+   Doubles capacity of deque, the elements are unwrapped to the
+   beginning of the new buffer.
+   @param d deque
+   @return deque or NULL on allocation failure
+*/
+static
+deque_t *
+deque_grow (deque_t * d)
+{
+  void ** buf;
+  const unsigned tail = d->cap - d->head;
+
+  buf = malloc (2 * d->cap * sizeof (void *));
+  if (! buf)
+    return NULL;
+  if (d->count <= tail)
+    memcpy (buf, d->buf + d->head, d->count * sizeof (void *));
+  else
+    {
+      memcpy (buf, d->buf + d->head, tail * sizeof (void *));
+      memcpy (buf + tail, d->buf, (d->count - tail) * sizeof (void *));
+    }
+  free (d->buf);
+  d->buf = buf;
+  d->head = 0;
+  d->cap *= 2;
+  return d;
+}
+
+
+/**
+   Initializes deque_t instance.
+   @param d deque
+   @return deque or NULL
+*/
+deque_t *
+deque_init (deque_t * d)
+{
+  d->buf = malloc (DEQUE_INITIAL * sizeof (void *));
+  if (! d->buf)
+    return NULL;
+  d->cap = DEQUE_INITIAL;
+  d->head = 0;
+  d->count = 0;
+  return d;
+}
+
+
+/**
+   Allocates and initializes a new deque.
+   @return new deque
+*/
+deque_t *
+deque_new (void)
+{
+  deque_t * d;
+
+  d = malloc (sizeof (deque_t));
+  if (! d)
+    return NULL;
+  if (! deque_init (d))
+    {
+      free (d);
+      return NULL;
+    }
+  else
+    return d;
+}
+
+
+/**
+   Destroys deque_t instance, the stored data are not touched.
+   @param d deque
+*/
+void
+deque_destroy (deque_t * d)
+{
+  free (d->buf);
+}
+
+
+/**
+   Deallocates and destroys deque.
+   @param d deque
+*/
+void
+deque_delete (deque_t * d)
+{
+  deque_destroy (d);
+  free (d);
+}
+
+
+/**
+   Pushes element onto the top of deque.
+   @param d deque
+   @param data pointer to stored data
+   @return pointer to stored data or NULL
+*/
+void *
+deque_push (deque_t * d, void * data)
+{
+  if (d->count == d->cap && ! deque_grow (d))
+    return NULL;
+  d->buf[slot (d, d->count)] = data;
+  d->count += 1;
+  return data;
+}
+
+
+/**
+   Pops one element from the top of deque.
+   @param d deque
+   @return pointer to data of the popped element
+*/
+void *
+deque_pop (deque_t * d)
+{
+  if (d->count == 0)
+    abort ();
+  d->count -= 1;
+  return d->buf[slot (d, d->count)];
+}
+
+
+/**
+   Same as deque_push() but to the bottom of deque.
+   @param d deque
+   @param data pointer to data
+   @return pointer to data or NULL
+*/
+void *
+deque_pushback (deque_t * d, void * data)
+{
+  if (d->count == d->cap && ! deque_grow (d))
+    return NULL;
+  d->head = (d->head - 1) & (d->cap - 1);
+  d->buf[d->head] = data;
+  d->count += 1;
+  return data;
+}
+
+
+/**
+   Same as deque_pop() but pops element from the bottom of deque.
+   @param d deque
+   @return pointer to data of the popped element
+*/
+void *
+deque_popback (deque_t * d)
+{
+  void * data;
+
+  if (d->count == 0)
+    abort ();
+  data = d->buf[d->head];
+  d->head = slot (d, 1);
+  d->count -= 1;
+  return data;
+}
+
+
+/**
+   Returns data of the top element or NULL when deque is empty.
+   @param d deque
+   @return pointer to data
+*/
+void *
+deque_top (const deque_t * d)
+{
+  return d->count ? d->buf[slot (d, d->count - 1)] : NULL;
+}
+
+
+/**
+   Returns data of the bottom element or NULL when deque is empty.
+   @param d deque
+   @return pointer to data
+*/
+void *
+deque_bottom (const deque_t * d)
+{
+  return d->count ? d->buf[d->head] : NULL;
+}
+
+
+/**
+   Removes up to count elements from the bottom of deque at once.
+   @param d deque
+   @param out array receiving the data, the bottom element first
+   @param count maximal number of elements to take
+   @return number of elements taken
+*/
+unsigned
+deque_take (deque_t * d, void ** out, unsigned count)
+{
+  unsigned i;
+
+  if (count > d->count)
+    count = d->count;
+  for (i = 0; i < count; ++i)
+    out[i] = d->buf[slot (d, i)];
+  d->head = slot (d, count);
+  d->count -= count;
+  return count;
+}
+
+
+/**
+   Returns number of elements in deque.
+   @param d deque
+   @return number of elements
+*/
+unsigned
+deque_size (const deque_t * d)
+{
+  return d->count;
+}
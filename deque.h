@@ -0,0 +1,61 @@
+/*
+Copyright (c) 1997-2007, Václav Haisman
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef _DEQUE_H_
+#define _DEQUE_H_
+
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /**
+     Double ended queue of pointers in a growable ring buffer. The owner
+     works at its top with deque_push()/deque_pop(), work is taken away
+     from its bottom.
+  */
+  struct _deque_t;
+  typedef struct _deque_t deque_t;
+
+  extern deque_t * deque_new (void);
+  extern deque_t * deque_init (deque_t * d);
+  extern void deque_destroy (deque_t * d);
+  extern void deque_delete (deque_t * d);
+  extern void * deque_push (deque_t * d, void * data);
+  extern void * deque_pop (deque_t * d);
+  extern void * deque_pushback (deque_t * d, void * data);
+  extern void * deque_popback (deque_t * d);
+  extern void * deque_top (const deque_t * d);
+  extern void * deque_bottom (const deque_t * d);
+  extern unsigned deque_take (deque_t * d, void ** out, unsigned count);
+  extern unsigned deque_size (const deque_t * d);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif
@@ -0,0 +1,218 @@
+/*
+Copyright (c) 1997-2007, Václav Haisman
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <stdlib.h>
+#include <limits.h>
+#include "heap.h"
+
+
+/* Position of node that is not in heap. */
+#define HEAP_OUT UINT_MAX
+
+
+struct _heap_t
+{
+  /* Capacity, nodes are 0 ... n-1. */
+  unsigned n;
+  unsigned count;
+  /* Nodes in heap order, positions of nodes in it and their keys. */
+  unsigned * node;
+  unsigned * pos;
+  long long * key;
+};
+
+
+/**
+   Allocates empty heap.
+   @param n number of nodes
+   @return new heap or NULL on allocation failure
+*/
+heap_t *
+heap_new (unsigned n)
+{
+  heap_t * h;
+  unsigned v;
+
+  h = malloc (sizeof (heap_t));
+  if (! h)
+    return NULL;
+  h->n = n;
+  h->count = 0;
+  h->node = malloc ((n ? n : 1) * sizeof (unsigned));
+  h->pos = malloc ((n ? n : 1) * sizeof (unsigned));
+  h->key = malloc ((n ? n : 1) * sizeof (long long));
+  if (! h->node || ! h->pos || ! h->key)
+    {
+      heap_delete (h);
+      return NULL;
+    }
+  for (v = 0; v < n; ++v)
+    h->pos[v] = HEAP_OUT;
+  return h;
+}
+
+
+/**
+   Frees memory allocated by heap.
+   @param h heap
+*/
+void
+heap_delete (heap_t * h)
+{
+  free (h->node);
+  free (h->pos);
+  free (h->key);
+  free (h);
+}
+
+
+/**
+   Returns number of nodes in heap.
+   @param h heap
+   @return number of nodes
+*/
+unsigned
+heap_count (const heap_t * h)
+{
+  return h->count;
+}
+
+
+/**
+   Tells whether node is in heap.
+   @param h heap
+   @param v node
+   @return true if v is in heap
+*/
+int
+heap_contains (const heap_t * h, unsigned v)
+{
+  if (v >= h->n)
+    abort ();
+  return h->pos[v] != HEAP_OUT;
+}
+
+
+/**
+   Returns key of node, which is in heap or was popped last time.
+   @param h heap
+   @param v node
+   @return key of v
+*/
+long long
+heap_key (const heap_t * h, unsigned v)
+{
+  if (v >= h->n)
+    abort ();
+  return h->key[v];
+}
+
+
+static
+void
+heap_up (heap_t * h, unsigned v)
+{
+  unsigned i = h->pos[v];
+
+  while (i > 0 && h->key[h->node[(i - 1) / 2]] < h->key[v])
+    {
+      h->node[i] = h->node[(i - 1) / 2];
+      h->pos[h->node[i]] = i;
+      i = (i - 1) / 2;
+    }
+  h->node[i] = v;
+  h->pos[v] = i;
+}
+
+
+/**
+   Inserts node that is not in heap.
+   @param h heap
+   @param v node
+   @param key key of v
+*/
+void
+heap_insert (heap_t * h, unsigned v, long long key)
+{
+  if (v >= h->n || h->pos[v] != HEAP_OUT)
+    abort ();
+  h->key[v] = key;
+  h->pos[v] = h->count++;
+  heap_up (h, v);
+}
+
+
+/**
+   Raises key of node in heap.
+   @param h heap
+   @param v node
+   @param delta nonnegative increment of key of v
+*/
+void
+heap_raise (heap_t * h, unsigned v, long long delta)
+{
+  if (v >= h->n || h->pos[v] == HEAP_OUT || delta < 0)
+    abort ();
+  h->key[v] += delta;
+  heap_up (h, v);
+}
+
+
+/**
+   Removes node with the largest key from heap.
+   @param h non-empty heap
+   @return the removed node
+*/
+unsigned
+heap_pop (heap_t * h)
+{
+  unsigned top, v, i = 0;
+
+  if (h->count == 0)
+    abort ();
+  top = h->node[0];
+  h->pos[top] = HEAP_OUT;
+  if (--h->count == 0)
+    return top;
+  v = h->node[h->count];
+  while (1)
+    {
+      unsigned c = 2 * i + 1;
+
+      if (c >= h->count)
+        break;
+      if (c + 1 < h->count && h->key[h->node[c+1]] > h->key[h->node[c]])
+        ++c;
+      if (h->key[h->node[c]] <= h->key[v])
+        break;
+      h->node[i] = h->node[c];
+      h->pos[h->node[i]] = i;
+      i = c;
+    }
+  h->node[i] = v;
+  h->pos[v] = i;
+  return top;
+}
@@ -0,0 +1,58 @@
+/*
+Copyright (c) 1997-2007, Václav Haisman
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef _HEAP_H_
+#define _HEAP_H_
+
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /**
+     Addressable binary max heap of nodes keyed by weights. Nodes are
+     counted from 0 and each is in the heap at most once, its key can be
+     raised while it is there. Key of a node stays readable after it is
+     popped until it is inserted again.
+  */
+  struct _heap_t;
+  typedef struct _heap_t heap_t;
+
+  extern heap_t * heap_new (unsigned n);
+  extern void heap_delete (heap_t * h);
+  extern unsigned heap_count (const heap_t * h);
+  extern int heap_contains (const heap_t * h, unsigned v);
+  extern long long heap_key (const heap_t * h, unsigned v);
+  extern void heap_insert (heap_t * h, unsigned v, long long key);
+  extern void heap_raise (heap_t * h, unsigned v, long long delta);
+  extern unsigned heap_pop (heap_t * h);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
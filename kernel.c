@@ -0,0 +1,188 @@
+/*
+Copyright (c) 1997-2007, Václav Haisman
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/* Intrinsics come before config.h, which defines __attribute__ away
+   when configure finds no support for it. */
+#if defined (__GNUC__) && (defined (__x86_64__) || defined (__i386__))
+# define KERNEL_X86 1
+# include <immintrin.h>
+#endif
+#include <stdlib.h>
+#include "kernel.h"
+
+#ifdef KERNEL_X86
+/* GCC always has it, target attributes select the instruction sets. */
+# undef __attribute__
+#endif
+
+
+masked_sum_t masked_sum;
+static const char * name = "none";
+
+
+/**
+   Tests bit i of bitmap words.
+*/
+static inline
+int
+bit (const bitmap_word_t * bits, unsigned i)
+{
+  return (bits[i / BITMAP_WORD_BITS] >> (i % BITMAP_WORD_BITS)) & 1;
+}
+
+
+/**
+   Portable implementation of masked_sum_t.
+*/
+static
+int
+masked_sum_scalar (const int * row, const bitmap_word_t * bits,
+                   unsigned n)
+{
+  unsigned i;
+  int sum = 0;
+
+  for (i = 0; i < n; ++i)
+    if (bit (bits, i))
+      sum += row[i];
+  return sum;
+}
+
+
+#ifdef KERNEL_X86
+/**
+   SSE2 implementation of masked_sum_t. Each nibble of bitmap word is
+   expanded into mask of four lanes.
+*/
+__attribute__ ((target ("sse2")))
+static
+int
+masked_sum_sse2 (const int * row, const bitmap_word_t * bits, unsigned n)
+{
+  const __m128i sel = _mm_setr_epi32 (1, 2, 4, 8);
+  __m128i acc = _mm_setzero_si128 ();
+  int lanes[4];
+  unsigned i;
+  int sum;
+
+  for (i = 0; i + 4 <= n; i += 4)
+    {
+      const int nibble
+        = (int)(bits[i / BITMAP_WORD_BITS] >> (i % BITMAP_WORD_BITS)) & 0xf;
+      __m128i mask;
+
+      if (! nibble)
+        continue;
+      mask = _mm_and_si128 (_mm_set1_epi32 (nibble), sel);
+      mask = _mm_cmpeq_epi32 (mask, sel);
+      acc = _mm_add_epi32 (acc, _mm_and_si128 (mask, 
+        _mm_loadu_si128 ((const __m128i *)(row + i))));
+    }
+  _mm_storeu_si128 ((__m128i *)lanes, acc);
+  sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+  for (; i < n; ++i)
+    if (bit (bits, i))
+      sum += row[i];
+  return sum;
+}
+
+
+/**
+   AVX2 implementation of masked_sum_t. Each byte of bitmap word is
+   expanded into mask of eight lanes.
+*/
+__attribute__ ((target ("avx2")))
+static
+int
+masked_sum_avx2 (const int * row, const bitmap_word_t * bits, unsigned n)
+{
+  const __m256i sel = _mm256_setr_epi32 (1, 2, 4, 8, 16, 32, 64, 128);
+  __m256i acc = _mm256_setzero_si256 ();
+  __m128i half;
+  unsigned i;
+  int sum;
+
+  for (i = 0; i + 8 <= n; i += 8)
+    {
+      const int byte
+        = (int)(bits[i / BITMAP_WORD_BITS] >> (i % BITMAP_WORD_BITS)) & 0xff;
+      __m256i mask;
+
+      if (! byte)
+        continue;
+      mask = _mm256_and_si256 (_mm256_set1_epi32 (byte), sel);
+      mask = _mm256_cmpeq_epi32 (mask, sel);
+      acc = _mm256_add_epi32 (acc, _mm256_and_si256 (mask, 
+        _mm256_loadu_si256 ((const __m256i *)(row + i))));
+    }
+  half = _mm_add_epi32 (_mm256_castsi256_si128 (acc),
+                        _mm256_extracti128_si256 (acc, 1));
+  half = _mm_add_epi32 (half, _mm_shuffle_epi32 (half, 0x4e));
+  half = _mm_add_epi32 (half, _mm_shuffle_epi32 (half, 0xb1));
+  sum = _mm_cvtsi128_si32 (half);
+  for (; i < n; ++i)
+    if (bit (bits, i))
+      sum += row[i];
+  return sum;
+}
+#endif
+
+
+/**
+   Selects the best implementation of kernels for the CPU we are
+   running on.
+*/
+void
+kernel_init (void)
+{
+#ifdef KERNEL_X86
+  __builtin_cpu_init ();
+  if (__builtin_cpu_supports ("avx2"))
+    {
+      masked_sum = masked_sum_avx2;
+      name = "avx2";
+      return;
+    }
+  if (__builtin_cpu_supports ("sse2"))
+    {
+      masked_sum = masked_sum_sse2;
+      name = "sse2";
+      return;
+    }
+#endif
+  masked_sum = masked_sum_scalar;
+  name = "scalar";
+}
+
+
+/**
+   Returns name of the selected implementation of kernels.
+*/
+const char *
+kernel_name (void)
+{
+  return name;
+}
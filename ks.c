@@ -0,0 +1,710 @@
+/*
+Copyright (c) 1997-2007, Václav Haisman
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include "gstdint.h"
+#include "ks.h"
+
+
+/* Graphs of at most this many nodes are solved exactly by ks_exact().
+   Recursion with the usual base of 6 nodes shrinks small graphs by a
+   single node per level while doubling the work. At most 64. */
+#define KS_BASE 32
+
+/* No node. */
+#define KS_NONE UINT_MAX
+
+
+/* Graph as list of edges, edge i joins end[2*i] and end[2*i+1]. Nodes
+   are counted from 0, there are no loops and no parallel edges. */
+struct _ksg_t
+{
+  unsigned n;
+  size_t m;
+  unsigned * end;
+  long long * wt;
+};
+typedef struct _ksg_t ksg_t;
+
+
+/* Contraction on the path from the graph of a component down to the
+   current graph, node v of the bigger graph of n nodes was contracted
+   into node to[v]. */
+struct _kslevel_t
+{
+  const unsigned * to;
+  unsigned n;
+  const struct _kslevel_t * up;
+};
+typedef struct _kslevel_t kslevel_t;
+
+
+/* Edge with its random key. */
+struct _ksorder_t
+{
+  double key;
+  size_t e;
+};
+typedef struct _ksorder_t ksorder_t;
+
+
+/* State of one run. */
+struct _ks_t
+{
+  /* Original nodes of the current component. */
+  const unsigned * orig;
+  /* Lightest cut found so far and its side. */
+  long long best;
+  bitmap_t * side;
+  /* State of random number generator of the current trial. */
+  uint64_t rng;
+  int failed;
+};
+typedef struct _ks_t ks_t;
+
+
+static
+void
+ksg_delete (ksg_t * g)
+{
+  free (g->end);
+  free (g->wt);
+  free (g);
+}
+
+
+static
+ksg_t *
+ksg_alloc (unsigned n, size_t m)
+{
+  ksg_t * g;
+
+  g = malloc (sizeof (ksg_t));
+  if (! g)
+    return NULL;
+  g->n = n;
+  g->m = m;
+  g->end = malloc ((m ? 2 * m : 1) * sizeof (unsigned));
+  g->wt = malloc ((m ? m : 1) * sizeof (long long));
+  if (! g->end || ! g->wt)
+    {
+      ksg_delete (g);
+      return NULL;
+    }
+  return g;
+}
+
+
+/**
+   Returns random number uniform on (0,1), xorshift64*.
+   @param k state
+   @return the number
+*/
+static
+double
+ks_uniform (ks_t * k)
+{
+  uint64_t x = k->rng;
+
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  k->rng = x;
+  return ((x * 2685821657736338717ull >> 11) + 0.5) / 9007199254740992.0;
+}
+
+
+/**
+   Seeds random number generator for a trial, splitmix64 of the trial
+   number spreads close seeds apart.
+   @param k state
+   @param seed seed of the whole run
+   @param trial number of trial
+*/
+static
+void
+ks_seed (ks_t * k, unsigned long seed, unsigned long trial)
+{
+  uint64_t x = (uint64_t)seed + (uint64_t)trial * 0x9e3779b97f4a7c15ull;
+
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  x ^= x >> 31;
+  k->rng = x ? x : 1;
+}
+
+
+static
+int
+compare_key (const void * a, const void * b)
+{
+  const double x = ((const ksorder_t *)a)->key;
+  const double y = ((const ksorder_t *)b)->key;
+
+  return x < y ? -1 : x > y;
+}
+
+
+static
+unsigned
+ks_find (unsigned * parent, unsigned x)
+{
+  while (parent[x] != x)
+    {
+      parent[x] = parent[parent[x]];
+      x = parent[x];
+    }
+  return x;
+}
+
+
+/**
+   Makes cut the best one if it is lighter. Its side is mapped back
+   through the contractions on the path to original nodes.
+   @param k state
+   @param up contractions leading to the current graph
+   @param n number of nodes of the current graph
+   @param in in[v] is true for nodes v on the side
+   @param weight weight of the cut
+*/
+static
+void
+ks_record (ks_t * k, const kslevel_t * up, unsigned n, const char * in,
+           long long weight)
+{
+  char * cur, * par;
+  unsigned v;
+
+  if (weight <= 0 || weight >= k->best)
+    return;
+  cur = malloc (n);
+  if (! cur)
+    {
+      k->failed = 1;
+      return;
+    }
+  memcpy (cur, in, n);
+  for (; up; up = up->up)
+    {
+      n = up->n;
+      par = malloc (n);
+      if (! par)
+        {
+          free (cur);
+          k->failed = 1;
+          return;
+        }
+      for (v = 0; v < n; ++v)
+        par[v] = cur[up->to[v]];
+      free (cur);
+      cur = par;
+    }
+  k->best = weight;
+  bitmap_clear (k->side);
+  for (v = 0; v < n; ++v)
+    if (cur[v])
+      bitmap_setbit (k->side, k->orig[v]);
+  free (cur);
+}
+
+
+/**
+   Checks trivial cuts of all nodes of graph.
+   @param k state
+   @param g graph
+   @param up contractions leading to g
+*/
+static
+void
+ks_degrees (ks_t * k, const ksg_t * g, const kslevel_t * up)
+{
+  long long * deg;
+  char * in;
+  unsigned v, min = KS_NONE;
+  size_t i;
+
+  deg = calloc (g->n, sizeof (long long));
+  in = calloc (g->n, 1);
+  if (! deg || ! in)
+    {
+      free (deg);
+      free (in);
+      k->failed = 1;
+      return;
+    }
+  for (i = 0; i < g->m; ++i)
+    {
+      deg[g->end[2*i]] += g->wt[i];
+      deg[g->end[2*i+1]] += g->wt[i];
+    }
+  for (v = 0; v < g->n; ++v)
+    if (deg[v] > 0 && (min == KS_NONE || deg[v] < deg[min]))
+      min = v;
+  if (min != KS_NONE && deg[min] < k->best)
+    {
+      in[min] = 1;
+      ks_record (k, up, g->n, in, deg[min]);
+    }
+  free (deg);
+  free (in);
+}
+
+
+/**
+   Solves small graph exactly by Stoer-Wagner algorithm on adjacency
+   matrix in O(n^3), nodes merged into each node are kept as bit masks.
+   @param k state
+   @param g connected graph of at most KS_BASE nodes
+   @param up contractions leading to g
+*/
+static
+void
+ks_exact (ks_t * k, const ksg_t * g, const kslevel_t * up)
+{
+  long long w[KS_BASE][KS_BASE], key[KS_BASE];
+  uint64_t members[KS_BASE];
+  char merged[KS_BASE], added[KS_BASE], in[KS_BASE];
+  unsigned alive, v, u, i, prev, last;
+  size_t e;
+
+  memset (w, 0, sizeof (w));
+  for (e = 0; e < g->m; ++e)
+    {
+      w[g->end[2*e]][g->end[2*e+1]] += g->wt[e];
+      w[g->end[2*e+1]][g->end[2*e]] += g->wt[e];
+    }
+  for (v = 0; v < g->n; ++v)
+    {
+      members[v] = (uint64_t)1 << v;
+      merged[v] = 0;
+    }
+  for (alive = g->n; alive > 1; --alive)
+    {
+      for (v = 0; v < g->n; ++v)
+        {
+          added[v] = merged[v];
+          key[v] = 0;
+        }
+      prev = last = KS_NONE;
+      for (i = 0; i < alive; ++i)
+        {
+          v = 0;
+          while (added[v])
+            ++v;
+          for (u = v + 1; u < g->n; ++u)
+            if (! added[u] && key[u] > key[v])
+              v = u;
+          added[v] = 1;
+          prev = last;
+          last = v;
+          for (u = 0; u < g->n; ++u)
+            if (! added[u])
+              key[u] += w[v][u];
+        }
+      /* The cut of the phase separates the last node. */
+      if (key[last] > 0 && key[last] < k->best)
+        {
+          for (v = 0; v < g->n; ++v)
+            in[v] = (members[last] >> v) & 1;
+          ks_record (k, up, g->n, in, key[last]);
+        }
+      for (u = 0; u < g->n; ++u)
+        {
+          w[prev][u] += w[last][u];
+          w[u][prev] = w[prev][u];
+        }
+      w[prev][prev] = 0;
+      members[prev] |= members[last];
+      merged[last] = 1;
+    }
+}
+
+
+/**
+   Builds graph on k nodes out of edges of g with ends mapped by to.
+   Loops are dropped and parallel edges merged in O(n + m).
+   @param g graph
+   @param to new node of each node of g
+   @param n number of new nodes
+   @return new graph or NULL on allocation failure
+*/
+static
+ksg_t *
+ks_build (const ksg_t * g, const unsigned * to, unsigned n)
+{
+  ksg_t * h;
+  size_t * first, * order, * slot, i, m = 0;
+  unsigned * mark;
+  unsigned a, b, c;
+
+  h = ksg_alloc (n, g->m);
+  first = calloc (n + 1, sizeof (size_t));
+  order = malloc ((g->m ? g->m : 1) * sizeof (size_t));
+  slot = malloc (n * sizeof (size_t));
+  mark = malloc (n * sizeof (unsigned));
+  if (! h || ! first || ! order || ! slot || ! mark)
+    {
+      if (h)
+        ksg_delete (h);
+      free (first);
+      free (order);
+      free (slot);
+      free (mark);
+      return NULL;
+    }
+  /* Sort surviving edges by their lower ends. */
+  for (i = 0; i < g->m; ++i)
+    {
+      a = to[g->end[2*i]];
+      b = to[g->end[2*i+1]];
+      if (a != b)
+        ++first[(a < b ? a : b) + 1];
+    }
+  for (c = 0; c < n; ++c)
+    {
+      first[c+1] += first[c];
+      slot[c] = first[c];
+      mark[c] = KS_NONE;
+    }
+  for (i = 0; i < g->m; ++i)
+    {
+      a = to[g->end[2*i]];
+      b = to[g->end[2*i+1]];
+      if (a != b)
+        order[slot[a < b ? a : b]++] = i;
+    }
+  /* Merge edges of each lower end by their higher ends, mark and slot
+     tell where edge to each higher end is. */
+  for (c = 0; c < n; ++c)
+    for (i = first[c]; i < first[c+1]; ++i)
+      {
+        const size_t e = order[i];
+
+        a = to[g->end[2*e]];
+        b = to[g->end[2*e+1]];
+        if (b == c)
+          b = a;
+        if (mark[b] == c)
+          h->wt[slot[b]] += g->wt[e];
+        else
+          {
+            mark[b] = c;
+            slot[b] = m;
+            h->end[2*m] = c;
+            h->end[2*m+1] = b;
+            h->wt[m++] = g->wt[e];
+          }
+      }
+  h->m = m;
+  free (first);
+  free (order);
+  free (slot);
+  free (mark);
+  return h;
+}
+
+
+/**
+   Contracts random edges until graph has target nodes. Edges are taken
+   in order of exponentially distributed keys with rates equal to their
+   weights, which is the same as picking each next edge with
+   probability proportional to its weight.
+   @param k state
+   @param g connected graph
+   @param target number of nodes to leave
+   @param to filled with new node of each node of g
+   @return new graph or NULL on allocation failure
+*/
+static
+ksg_t *
+ks_contract (ks_t * k, const ksg_t * g, unsigned target, unsigned * to)
+{
+  ksorder_t * order;
+  unsigned * parent;
+  unsigned v, count = g->n, id = 0;
+  size_t i;
+  ksg_t * h;
+
+  order = malloc ((g->m ? g->m : 1) * sizeof (ksorder_t));
+  parent = malloc (g->n * sizeof (unsigned));
+  if (! order || ! parent)
+    {
+      free (order);
+      free (parent);
+      return NULL;
+    }
+  for (i = 0; i < g->m; ++i)
+    {
+      order[i].key = -log (ks_uniform (k)) / g->wt[i];
+      order[i].e = i;
+    }
+  qsort (order, g->m, sizeof (ksorder_t), compare_key);
+  for (v = 0; v < g->n; ++v)
+    parent[v] = v;
+  for (i = 0; i < g->m && count > target; ++i)
+    {
+      const unsigned a = ks_find (parent, g->end[2*order[i].e]);
+      const unsigned b = ks_find (parent, g->end[2*order[i].e+1]);
+
+      if (a != b)
+        {
+          parent[b] = a;
+          --count;
+        }
+    }
+  for (v = 0; v < g->n; ++v)
+    {
+      parent[v] = ks_find (parent, v);
+      to[v] = KS_NONE;
+    }
+  for (v = 0; v < g->n; ++v)
+    if (to[parent[v]] == KS_NONE)
+      to[parent[v]] = id++;
+  for (v = 0; v < g->n; ++v)
+    parent[v] = to[parent[v]];
+  memcpy (to, parent, g->n * sizeof (unsigned));
+  h = ks_build (g, to, count);
+  free (order);
+  free (parent);
+  return h;
+}
+
+
+/**
+   Recursive contraction. The graph is contracted to about n/sqrt(2)
+   nodes twice independently and both results are solved recursively,
+   each keeps a given minimum cut with probability at least 1/2.
+   @param k state
+   @param g connected graph
+   @param up contractions leading to g
+*/
+static
+void
+ks_recurse (ks_t * k, const ksg_t * g, const kslevel_t * up)
+{
+  unsigned target, i;
+
+  if (g->n <= KS_BASE)
+    {
+      ks_exact (k, g, up);
+      return;
+    }
+  ks_degrees (k, g, up);
+  target = (unsigned)ceil (1 + g->n / sqrt (2.0));
+  for (i = 0; i < 2 && ! k->failed; ++i)
+    {
+      unsigned * to = malloc (g->n * sizeof (unsigned));
+      kslevel_t level;
+      ksg_t * h;
+
+      h = to ? ks_contract (k, g, target, to) : NULL;
+      if (! h)
+        {
+          free (to);
+          k->failed = 1;
+          return;
+        }
+      level.to = to;
+      level.n = g->n;
+      level.up = up;
+      ks_recurse (k, h, &level);
+      ksg_delete (h);
+      free (to);
+    }
+}
+
+
+/**
+   Returns number of trials needed to find minimum cut of connected
+   graph with probability at least 1 - failure. A trial of depth d
+   succeeds with probability at least 1/(d+1), see Karger and Stein.
+   @param n number of nodes
+   @param failure allowed probability of not finding the minimum cut
+   @return number of trials
+*/
+unsigned long
+ks_trials (unsigned n, double failure)
+{
+  unsigned depth = 0;
+  double trials;
+
+  if (n <= KS_BASE)
+    return 1;
+  if (failure <= 0 || failure >= 1)
+    abort ();
+  while (n > KS_BASE)
+    {
+      n = (unsigned)ceil (1 + n / sqrt (2.0));
+      ++depth;
+    }
+  trials = ceil (log (1 / failure) * (depth + 1));
+  return trials < 1 ? 1 : (unsigned long)trials;
+}
+
+
+/**
+   Finds minimum cut of positive weight with probability at least
+   1 - failure. Connected components with at least two nodes are solved
+   separately by ks_trials() trials each, the minimum cut lies in one of
+   them. Trials are numbered through all components, this call runs
+   those numbered first, first + stride, ... Edges of zero weight are
+   ignored.
+   @param g graph
+   @param failure allowed probability of not finding the minimum cut
+   @param seed seed of random numbers, trials of the same number run
+   with the same seed give the same cut
+   @param first number of the first trial to run
+   @param stride distance of numbers of trials to run
+   @param side bitmap of at least csr_nodes(g) bits, set to one side of
+   the cut
+   @param weight weight of the cut, LLONG_MAX when no trial found a cut
+   and side is empty
+   @return true on success, false on allocation failure
+*/
+int
+ks_mincut (const csr_t * g, double failure, unsigned long seed,
+           unsigned long first, unsigned long stride, bitmap_t * side,
+           long long * weight)
+{
+  const unsigned n = csr_nodes (g);
+  const unsigned * nbr;
+  const int * wt;
+  unsigned * parent, * cid, * comp, * local;
+  size_t * start, * fill;
+  unsigned x, y, i, deg, c, count = 0;
+  unsigned long trial = 0, t, trials;
+  ks_t k;
+
+  if (bitmap_size (side) < n || stride == 0)
+    abort ();
+  k.best = LLONG_MAX;
+  k.side = side;
+  k.failed = 0;
+  bitmap_clear (side);
+  parent = malloc (n * sizeof (unsigned));
+  cid = malloc (n * sizeof (unsigned));
+  comp = malloc (n * sizeof (unsigned));
+  local = malloc (n * sizeof (unsigned));
+  start = calloc (n + 1, sizeof (size_t));
+  fill = malloc ((n + 1) * sizeof (size_t));
+  if (! parent || ! cid || ! comp || ! local || ! start || ! fill)
+    {
+      free (parent);
+      free (cid);
+      free (comp);
+      free (local);
+      free (start);
+      free (fill);
+      return 0;
+    }
+  /* Connected components, numbered by their lowest nodes. */
+  for (x = 0; x < n; ++x)
+    parent[x] = x;
+  for (x = 0; x < n; ++x)
+    {
+      deg = csr_row (g, x + 1, &nbr, &wt);
+      for (i = 0; i < deg; ++i)
+        if (wt[i] > 0)
+          {
+            const unsigned a = ks_find (parent, x);
+            const unsigned b = ks_find (parent, nbr[i] - 1);
+
+            if (a != b)
+              parent[a < b ? b : a] = a < b ? a : b;
+          }
+    }
+  for (x = 0; x < n; ++x)
+    {
+      const unsigned r = ks_find (parent, x);
+
+      cid[x] = r == x ? count++ : cid[r];
+      ++start[cid[x] + 1];
+    }
+  for (c = 0; c < count; ++c)
+    start[c+1] += start[c];
+  /* Nodes of each component in comp, their numbers in it in local.
+     Components may interleave, fill is the next free slot of each. */
+  memcpy (fill, start, (count + 1) * sizeof (size_t));
+  for (x = 0; x < n; ++x)
+    {
+      const unsigned cx = cid[x];
+
+      local[x] = (unsigned)(fill[cx] - start[cx]);
+      comp[fill[cx]++] = x;
+    }
+
+  for (c = 0; c < count && ! k.failed; ++c)
+    {
+      const unsigned size = (unsigned)(start[c+1] - start[c]);
+      ksg_t * h;
+      size_t m = 0;
+
+      if (size < 2)
+        continue;
+      for (i = 0; i < size; ++i)
+        m += csr_row (g, comp[start[c] + i] + 1, &nbr, &wt);
+      h = ksg_alloc (size, m / 2);
+      if (! h)
+        {
+          k.failed = 1;
+          break;
+        }
+      m = 0;
+      for (i = 0; i < size; ++i)
+        {
+          x = comp[start[c] + i];
+          deg = csr_row (g, x + 1, &nbr, &wt);
+          for (y = 0; y < deg; ++y)
+            if (nbr[y] - 1 > x && wt[y] > 0)
+              {
+                h->end[2*m] = i;
+                h->end[2*m+1] = local[nbr[y] - 1];
+                h->wt[m++] = wt[y];
+              }
+        }
+      h->m = m;
+      k.orig = comp + start[c];
+      trials = ks_trials (size, failure);
+      for (t = 0; t < trials && ! k.failed; ++t, ++trial)
+        if (trial % stride == first)
+          {
+            ks_seed (&k, seed, trial);
+            ks_recurse (&k, h, NULL);
+          }
+      ksg_delete (h);
+    }
+  free (parent);
+  free (cid);
+  free (comp);
+  free (local);
+  free (start);
+  free (fill);
+  *weight = k.best;
+  return ! k.failed;
+}
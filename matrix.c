@@ -26,15 +26,10 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 #include "matrix.h"
 #include "bitmap.h"
+#include "matrix_priv.h"
 #include <stdlib.h>
 #include <string.h>
-
-
-struct _trimatrix_t
-{
-  bitmap_t * bm;
-  unsigned n;
-};
+#include <limits.h>
 
 
 /**
@@ -44,35 +39,21 @@ struct _trimatrix_t
    @return number of elements of storage for matrix
 */
 static inline
-unsigned
+size_t
 elems_from_n (unsigned n)
 {
-  return (unsigned)((n * (n + 1ull)) / 2);
-}
-
-
-static inline
-unsigned
-index_for_nxy (unsigned _n, unsigned x, unsigned y)
-{
-  const unsigned long n = _n;
-
-  if (y > x)
-    {
-      unsigned tmp = x;
-      x = y;
-      y = tmp;
-    }
-  return (unsigned)(((y - 1) * (n + (n - (y-1-1)))) / 2
-                    + (x - (y - 1)) - 1);
+  return (size_t)((n * (n + 1ull)) / 2);
 }
 
 
 /**
-   Initializes trimatrix_t of edge size n.
+   Initializes trimatrix_t of edge size n. Bits of the matrix are
+   addressed by unsigned positions of bitmap_t, so n is limited to
+   about 92000.
    @param mx matrix
    @param n height/width of matrix
-   @return initialized matrix
+   @return initialized matrix or NULL when it is too large or
+   allocation fails
 */
 inline
 trimatrix_t *
@@ -80,6 +61,8 @@ trimatrix_init (trimatrix_t * mx, unsigned n)
 {
   if (n == 0)
     abort ();
+  if (elems_from_n (n) > UINT_MAX)
+    return NULL;
   mx->bm = bitmap_new (elems_from_n (n));
   if (! mx->bm)
     return NULL;
@@ -191,6 +174,28 @@ trimatrix_set (const trimatrix_t * mx, unsigned x, unsigned y, int val)
 }
 
 
+/**
+   Makes copy of matrix with relabelled rows and columns.
+   @param mx matrix
+   @param pos pos[x-1] is the new coordinate of old coordinate x
+   @return new matrix or NULL on allocation failure
+*/
+trimatrix_t *
+trimatrix_permute (const trimatrix_t * mx, const unsigned * pos)
+{
+  trimatrix_t * newmx;
+  unsigned x, y;
+
+  newmx = trimatrix_new (mx->n);
+  if (! newmx)
+    return NULL;
+  for (x = 1; x <= mx->n; ++x)
+    for (y = x; y <= mx->n; ++y)
+      trimatrix_set (newmx, pos[x-1], pos[y-1], trimatrix_get (mx, x, y));
+  return newmx;
+}
+
+
 /**
    Returns how many bytes are needed to serialize trimatrix.
 */
@@ -249,31 +254,56 @@ trimatrix_deserialize (const void * buf, size_t * pos)
 
 
 /**
-
+   Returns the narrowest width of element that can hold val.
+   @param val value
+   @return width in bytes
 */
-struct _wtrimatrix_t
+static
+unsigned
+width_for_value (wvalue_t val)
 {
-  unsigned char * buf;
-  unsigned n;
-};
+  if (val <= UINT8_MAX)
+    return 1;
+  else if (val <= UINT16_MAX)
+    return 2;
+  else if (val <= UINT32_MAX)
+    return 4;
+  else
+    return 8;
+}
 
 
+/**
+   Initializes wtrimatrix_t of edge size n with elements of given width.
+   @param mx matrix
+   @param n edge size
+   @param width width of elements in bytes, 1, 2, 4 or 8
+   @return mx or NULL on allocation failure
+*/
 wtrimatrix_t * 
-wtrimatrix_init (wtrimatrix_t * mx, unsigned n)
+wtrimatrix_init_width (wtrimatrix_t * mx, unsigned n, unsigned width)
 {
-  if (n == 0)
+  if (n == 0
+      || (width != 1 && width != 2 && width != 4 && width != 8))
     abort ();
-  mx->buf = malloc (elems_from_n (n));
+  mx->buf = calloc (elems_from_n (n), width);
   if (! mx->buf)
     return NULL;
-  memset (mx->buf, 0, elems_from_n (n));
   mx->n = n;
+  mx->width = width;
   return mx;
 }
 
 
 wtrimatrix_t * 
-wtrimatrix_new (unsigned n)
+wtrimatrix_init (wtrimatrix_t * mx, unsigned n)
+{
+  return wtrimatrix_init_width (mx, n, 1);
+}
+
+
+wtrimatrix_t * 
+wtrimatrix_new_width (unsigned n, unsigned width)
 {
   wtrimatrix_t * mx;
   
@@ -282,7 +312,7 @@ wtrimatrix_new (unsigned n)
   mx = malloc (sizeof (wtrimatrix_t));
   if (! mx)
     return NULL;
-  if (! wtrimatrix_init (mx, n))
+  if (! wtrimatrix_init_width (mx, n, width))
     {
       free (mx);
       return NULL;
@@ -292,6 +322,13 @@ wtrimatrix_new (unsigned n)
 }
 
 
+wtrimatrix_t * 
+wtrimatrix_new (unsigned n)
+{
+  return wtrimatrix_new_width (n, 1);
+}
+
+
 inline
 void 
 wtrimatrix_destruct (wtrimatrix_t * mx)
@@ -316,45 +353,110 @@ wtrimatrix_clone (const wtrimatrix_t * mx)
   newmx = malloc (sizeof (wtrimatrix_t));
   if (! newmx)
     return NULL;
-  newmx->buf = malloc (elems_from_n (mx->n));
+  newmx->buf = malloc ((size_t)elems_from_n (mx->n) * mx->width);
   if (! newmx->buf)
     {
       free (newmx);
       return NULL;
     }
   newmx->n = mx->n;
-  memcpy (newmx->buf, mx->buf, elems_from_n (newmx->n));
+  newmx->width = mx->width;
+  memcpy (newmx->buf, mx->buf, (size_t)elems_from_n (newmx->n) * mx->width);
   
   return newmx;
 }
 
 
-unsigned 
+/**
+   Returns width of elements of matrix.
+   @param mx matrix
+   @return width in bytes
+*/
+unsigned
+wtrimatrix_width (const wtrimatrix_t * mx)
+{
+  return mx->width;
+}
+
+
+/**
+   Widens elements of matrix so that val can be stored into it. Matrix
+   is left as it is when val already fits.
+   @param mx matrix
+   @param val value
+   @return mx or NULL on allocation failure, matrix is unchanged then
+*/
+wtrimatrix_t *
+wtrimatrix_fit (wtrimatrix_t * mx, wvalue_t val)
+{
+  wtrimatrix_t wider;
+  const size_t elems = elems_from_n (mx->n);
+  size_t i;
+
+  if (width_for_value (val) <= mx->width)
+    return mx;
+  if (! wtrimatrix_init_width (&wider, mx->n, width_for_value (val)))
+    return NULL;
+  for (i = 0; i < elems; ++i)
+    wtrimatrix_store (&wider, i, wtrimatrix_load (mx, i));
+  wtrimatrix_destruct (mx);
+  *mx = wider;
+  return mx;
+}
+
+
+wvalue_t 
 wtrimatrix_get (const wtrimatrix_t * mx, unsigned x, unsigned y)
 {
   if (x > mx->n || y > mx->n
       || x == 0 || y == 0)
     abort ();
 
-  return (unsigned)mx->buf[index_for_nxy (mx->n, x, y)];
+  return wtrimatrix_load (mx, index_for_nxy (mx->n, x, y));
 }
 
 
-unsigned 
-wtrimatrix_set (const wtrimatrix_t * mx, unsigned x, unsigned y, unsigned char val)
+wvalue_t 
+wtrimatrix_set (const wtrimatrix_t * mx, unsigned x, unsigned y, wvalue_t val)
 {
-  const unsigned i = index_for_nxy (mx->n, x, y);
-  const unsigned prev = mx->buf[i];
+  size_t i;
+  wvalue_t prev;
 
   if (x > mx->n || y > mx->n
-      || x == 0 || y == 0)
+      || x == 0 || y == 0
+      || width_for_value (val) > mx->width)
     abort ();
   
-  mx->buf[i] = val;
+  i = index_for_nxy (mx->n, x, y);
+  prev = wtrimatrix_load (mx, i);
+  wtrimatrix_store (mx, i, val);
   return prev;
 }
 
 
+/**
+   Makes copy of matrix with relabelled rows and columns, width of
+   elements is kept.
+   @param mx matrix
+   @param pos pos[x-1] is the new coordinate of old coordinate x
+   @return new matrix or NULL on allocation failure
+*/
+wtrimatrix_t *
+wtrimatrix_permute (const wtrimatrix_t * mx, const unsigned * pos)
+{
+  wtrimatrix_t * newmx;
+  unsigned x, y;
+
+  newmx = wtrimatrix_new_width (mx->n, mx->width);
+  if (! newmx)
+    return NULL;
+  for (x = 1; x <= mx->n; ++x)
+    for (y = x; y <= mx->n; ++y)
+      wtrimatrix_set (newmx, pos[x-1], pos[y-1], wtrimatrix_get (mx, x, y));
+  return newmx;
+}
+
+
 /*
 size_t 
 wtrimatrix_serialize_size (const wtrimatrix_t * mx)
@@ -406,3 +508,192 @@ wtrimatrix_deserialize (const void * buf, size_t * pos)
   return mx;
 }
 */
+
+
+/* Size of cache line rows of sqmatrix_t are aligned to. */
+#define SQMATRIX_ALIGN 64
+
+
+/**
+   Initializes sqmatrix_t of edge size n with zeros.
+   @param mx matrix
+   @param n height/width of matrix
+   @return initialized matrix or NULL
+*/
+sqmatrix_t *
+sqmatrix_init (sqmatrix_t * mx, unsigned n)
+{
+  const size_t line = SQMATRIX_ALIGN / sizeof (int);
+  size_t size;
+
+  if (n == 0)
+    abort ();
+  mx->stride = (n + line - 1) / line * line;
+  size = mx->stride * n * sizeof (int);
+  if (size / n / sizeof (int) != mx->stride)
+    return NULL;
+  mx->mem = malloc (size + SQMATRIX_ALIGN - 1);
+  if (! mx->mem)
+    return NULL;
+  mx->buf = (int *)(((size_t)mx->mem + SQMATRIX_ALIGN - 1)
+                    & ~(size_t)(SQMATRIX_ALIGN - 1));
+  memset (mx->buf, 0, size);
+  mx->n = n;
+  return mx;
+}
+
+
+/**
+   Allocates and initializes matrix.
+   @param n height/width of matrix
+   @return matrix or NULL
+*/
+sqmatrix_t *
+sqmatrix_new (unsigned n)
+{
+  sqmatrix_t * mx;
+
+  if (n == 0)
+    abort ();
+  mx = malloc (sizeof (sqmatrix_t));
+  if (! mx)
+    return NULL;
+  if (! sqmatrix_init (mx, n))
+    {
+      free (mx);
+      return NULL;
+    }
+  else
+    return mx;
+}
+
+
+/**
+   Destructor of matrix.
+   @param mx matrix
+*/
+void
+sqmatrix_destruct (sqmatrix_t * mx)
+{
+  free (mx->mem);
+}
+
+
+/**
+   Destructs matrix and frees allocated memory.
+   @param mx matrix
+*/
+void
+sqmatrix_delete (sqmatrix_t * mx)
+{
+  sqmatrix_destruct (mx);
+  free (mx);
+}
+
+
+/**
+   Duplicates matrix.
+   @param mx matrix to clone
+   @return clone of first parameter
+*/
+sqmatrix_t *
+sqmatrix_clone (const sqmatrix_t * mx)
+{
+  sqmatrix_t * newmx;
+
+  newmx = sqmatrix_new (mx->n);
+  if (! newmx)
+    return NULL;
+  memcpy (newmx->buf, mx->buf, mx->stride * mx->n * sizeof (int));
+  return newmx;
+}
+
+
+/**
+   Expands triangular matrix into full symmetric matrix. Elements have
+   to fit into int.
+   @param wmx matrix
+   @return newly allocated matrix or NULL
+*/
+sqmatrix_t *
+sqmatrix_from_wtrimatrix (const wtrimatrix_t * wmx)
+{
+  sqmatrix_t * mx;
+  unsigned x, y;
+
+  mx = sqmatrix_new (wmx->n);
+  if (! mx)
+    return NULL;
+  for (x = 1; x <= wmx->n; ++x)
+    for (y = x + 1; y <= wmx->n; ++y)
+      sqmatrix_set (mx, x, y, (int)wtrimatrix_get_fast (wmx, x, y));
+  return mx;
+}
+
+
+/**
+   Returns an element at position (x,y) in matrix.
+   @param mx matrix
+   @param x X coordinate
+   @param y Y coordinate
+   @return value
+*/
+int
+sqmatrix_get (const sqmatrix_t * mx, unsigned x, unsigned y)
+{
+  if (x > mx->n || y > mx->n
+      || x == 0 || y == 0)
+    abort ();
+  return mx->buf[(x - 1) * mx->stride + y - 1];
+}
+
+
+/**
+   Sets a value to elements at positions (x,y) and (y,x) in matrix.
+   @param mx matrix
+   @param x X coordinate
+   @param y Y coordinate
+   @param val value
+   @return previous value
+*/
+int
+sqmatrix_set (sqmatrix_t * mx, unsigned x, unsigned y, int val)
+{
+  int prev;
+
+  if (x > mx->n || y > mx->n
+      || x == 0 || y == 0)
+    abort ();
+  prev = mx->buf[(x - 1) * mx->stride + y - 1];
+  mx->buf[(x - 1) * mx->stride + y - 1] = val;
+  mx->buf[(y - 1) * mx->stride + x - 1] = val;
+  return prev;
+}
+
+
+/**
+   Returns row x of matrix. Element (x,y) is at index y-1, the row is
+   aligned to cache line and zero padded up to sqmatrix_stride().
+   @param mx matrix
+   @param x row
+   @return row
+*/
+const int *
+sqmatrix_row (const sqmatrix_t * mx, unsigned x)
+{
+  if (x > mx->n || x == 0)
+    abort ();
+  return mx->buf + (x - 1) * mx->stride;
+}
+
+
+/**
+   Returns distance between starts of two consecutive rows in elements.
+   @param mx matrix
+   @return number of elements of padded row
+*/
+size_t
+sqmatrix_stride (const sqmatrix_t * mx)
+{
+  return mx->stride;
+}
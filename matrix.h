@@ -29,6 +29,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <stddef.h>
 #include "config.h"
+#include "gstdint.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -55,6 +56,8 @@ extern "C" {
   extern void trimatrix_destruct (trimatrix_t * mx);
   extern trimatrix_t * trimatrix_clone (const trimatrix_t * mx);
   extern int trimatrix_get (const trimatrix_t * mx, unsigned x, unsigned y);
+  extern trimatrix_t * trimatrix_permute (const trimatrix_t * mx,
+                                          const unsigned * pos);
   extern int trimatrix_set (const trimatrix_t * mx, 
                             unsigned x, unsigned y, int val);
   /* extern size_t trimatrix_serialize_size (const trimatrix_t * mx);
@@ -65,27 +68,62 @@ extern "C" {
   
 
   /**
-     Upper triangular matrix with diagonal with elements of type 
-     unsigned char.
+     Type of elements of weighted matrices.
+  */
+  typedef uint64_t wvalue_t;
+
+
+  /**
+     Upper triangular matrix with diagonal with elements of type
+     wvalue_t. Elements are stored in 1, 2, 4 or 8 bytes each, matrix
+     is widened by wtrimatrix_fit() when a value does not fit.
   */
   struct _wtrimatrix_t;
   typedef struct _wtrimatrix_t wtrimatrix_t;
 
   extern wtrimatrix_t * wtrimatrix_new (unsigned n);
+  extern wtrimatrix_t * wtrimatrix_new_width (unsigned n, unsigned width);
   extern wtrimatrix_t * wtrimatrix_init (wtrimatrix_t * mx, unsigned n);
+  extern wtrimatrix_t * wtrimatrix_init_width (wtrimatrix_t * mx, unsigned n,
+                                               unsigned width);
   extern void wtrimatrix_delete (wtrimatrix_t * mx);
   extern void wtrimatrix_destruct (wtrimatrix_t * mx);
   extern wtrimatrix_t * wtrimatrix_clone (const wtrimatrix_t * mx);
-  extern unsigned wtrimatrix_get (const wtrimatrix_t * mx, 
+  extern unsigned wtrimatrix_width (const wtrimatrix_t * mx);
+  extern wtrimatrix_t * wtrimatrix_fit (wtrimatrix_t * mx, wvalue_t val);
+  extern wvalue_t wtrimatrix_get (const wtrimatrix_t * mx, 
                                   unsigned x, unsigned y);
-  extern unsigned wtrimatrix_set (const wtrimatrix_t * mx, 
-                                  unsigned x, unsigned y, unsigned char val);
+  extern wvalue_t wtrimatrix_set (const wtrimatrix_t * mx, 
+                                  unsigned x, unsigned y, wvalue_t val);
+  extern wtrimatrix_t * wtrimatrix_permute (const wtrimatrix_t * mx,
+                                            const unsigned * pos);
   /* extern size_t wtrimatrix_serialize_size (const wtrimatrix_t * mx);
   extern wtrimatrix_t * wtrimatrix_deserialize (const void * buf,
                                                 size_t * pos);
   extern void wtrimatrix_serialize (void * buf, size_t * size, size_t * pos,
   const wtrimatrix_t * mx); */
 
+
+  /**
+     Full symmetric matrix of ints stored by rows. Each row is padded
+     to a whole number of cache lines and starts at a cache line
+     boundary, so that all neighbours of a node are scanned
+     sequentially. Rows and columns counted from 1, padding is zero.
+  */
+  struct _sqmatrix_t;
+  typedef struct _sqmatrix_t sqmatrix_t;
+
+  extern sqmatrix_t * sqmatrix_new (unsigned n);
+  extern sqmatrix_t * sqmatrix_init (sqmatrix_t * mx, unsigned n);
+  extern void sqmatrix_delete (sqmatrix_t * mx);
+  extern void sqmatrix_destruct (sqmatrix_t * mx);
+  extern sqmatrix_t * sqmatrix_clone (const sqmatrix_t * mx);
+  extern sqmatrix_t * sqmatrix_from_wtrimatrix (const wtrimatrix_t * wmx);
+  extern int sqmatrix_get (const sqmatrix_t * mx, unsigned x, unsigned y);
+  extern int sqmatrix_set (sqmatrix_t * mx, unsigned x, unsigned y, int val);
+  extern const int * sqmatrix_row (const sqmatrix_t * mx, unsigned x);
+  extern size_t sqmatrix_stride (const sqmatrix_t * mx);
+
 #ifdef __cplusplus
 }
 #endif
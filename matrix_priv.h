@@ -0,0 +1,184 @@
+/*
+Copyright (c) 1997-2007, Václav Haisman
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef _MATRIX_PRIV_H_
+#define _MATRIX_PRIV_H_
+
+/* Representation of matrices and unchecked inline accessors for hot
+   loops. Coordinates are checked only when CHECKED_ACCESS is defined. */
+
+#include <stdlib.h>
+#include "config.h"
+#include "matrix.h"
+#include "bitmap.h"
+#include "bitmap_priv.h"
+
+#ifdef CHECKED_ACCESS
+# define MATRIX_CHECK(mx, x, y)                                         \
+  do {                                                                  \
+    if ((x) > (mx)->n || (y) > (mx)->n || (x) == 0 || (y) == 0)         \
+      abort ();                                                         \
+  } while (0)
+#else
+# define MATRIX_CHECK(mx, x, y) ((void)0)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  struct _trimatrix_t
+  {
+    bitmap_t * bm;
+    unsigned n;
+  };
+
+
+  struct _wtrimatrix_t
+  {
+    /* Elements of width bytes each. */
+    void * buf;
+    unsigned n;
+    unsigned width;
+  };
+
+
+  struct _sqmatrix_t
+  {
+    /* Allocated memory, buf is aligned within it. */
+    void * mem;
+    int * buf;
+    unsigned n;
+    /* Number of elements of a row including padding. */
+    size_t stride;
+  };
+
+
+  /**
+     Computes index of element (x,y) in storage of triangular matrix.
+  */
+  static inline
+  size_t
+  index_for_nxy (unsigned _n, unsigned x, unsigned y)
+  {
+    const size_t n = _n;
+
+    if (y > x)
+      {
+        unsigned tmp = x;
+        x = y;
+        y = tmp;
+      }
+    return ((y - 1) * (n + (n - (y-1-1)))) / 2 + (x - (y - 1)) - 1;
+  }
+
+
+  static inline
+  int
+  trimatrix_get_fast (const trimatrix_t * mx, unsigned x, unsigned y)
+  {
+    MATRIX_CHECK (mx, x, y);
+    return bitmap_getbit_fast (mx->bm, index_for_nxy (mx->n, x, y));
+  }
+
+
+  /**
+     Reads element i of storage of weighted matrix.
+  */
+  static inline
+  wvalue_t
+  wtrimatrix_load (const wtrimatrix_t * mx, size_t i)
+  {
+    switch (mx->width)
+      {
+      case 1:
+        return ((const uint8_t *)mx->buf)[i];
+      case 2:
+        return ((const uint16_t *)mx->buf)[i];
+      case 4:
+        return ((const uint32_t *)mx->buf)[i];
+      default:
+        return ((const uint64_t *)mx->buf)[i];
+      }
+  }
+
+
+  /**
+     Writes element i of storage of weighted matrix, val has to fit
+     into its width.
+  */
+  static inline
+  void
+  wtrimatrix_store (const wtrimatrix_t * mx, size_t i, wvalue_t val)
+  {
+    switch (mx->width)
+      {
+      case 1:
+        ((uint8_t *)mx->buf)[i] = (uint8_t)val;
+        break;
+      case 2:
+        ((uint16_t *)mx->buf)[i] = (uint16_t)val;
+        break;
+      case 4:
+        ((uint32_t *)mx->buf)[i] = (uint32_t)val;
+        break;
+      default:
+        ((uint64_t *)mx->buf)[i] = val;
+      }
+  }
+
+
+  static inline
+  wvalue_t
+  wtrimatrix_get_fast (const wtrimatrix_t * mx, unsigned x, unsigned y)
+  {
+    MATRIX_CHECK (mx, x, y);
+    return wtrimatrix_load (mx, index_for_nxy (mx->n, x, y));
+  }
+
+
+  static inline
+  int
+  sqmatrix_get_fast (const sqmatrix_t * mx, unsigned x, unsigned y)
+  {
+    MATRIX_CHECK (mx, x, y);
+    return mx->buf[(x - 1) * mx->stride + y - 1];
+  }
+
+
+  static inline
+  const int *
+  sqmatrix_row_fast (const sqmatrix_t * mx, unsigned x)
+  {
+    MATRIX_CHECK (mx, x, 1);
+    return mx->buf + (x - 1) * mx->stride;
+  }
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif
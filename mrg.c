@@ -25,6 +25,7 @@ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 #include <stdlib.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <errno.h>
 #include <string.h>
@@ -34,8 +35,17 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <mpi.h>
 #include "config.h"
 #include "bitmap.h"
+#include "bitmap_priv.h"
 #include "matrix.h"
-#include "list.h"
+#include "matrix_priv.h"
+#include "deque.h"
+#include "csr.h"
+#include "kernel.h"
+#include "planes.h"
+#include "sw.h"
+#include "pmc.h"
+#include "ks.h"
+#include "reduce.h"
 #include "utility.h"
 
 
@@ -54,6 +64,49 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define MSG_DREQ 'O' /* Request donor from P1. */
 #define MSG_EOE 'F' /* No more stack elements are coming. */
 
+#define USAGE "Syntax: mrg [-a] [-u] [-d] [-c] [-y] [-w] [-e] [-g bits] [-k bits]"\
+  " [-r auto|dense|sparse|planes|fixed] [-o none|degree|bfs] [-m dfs|sw|par|ks]"\
+  " [-t threads] [-p failure] [-x]"\
+  " <input graph>\n"\
+  "Weights of all edges may sum up to 2^62, nodes of weighted degree 2^30"\
+  " and more are searched only by -m dfs, without -o and the reduction."
+
+/* Graphs with at most this ratio of edges to all possible edges are
+   scanned through their sparse representation in auto mode. */
+#define SPARSE_DENSITY 0.25
+
+/* Dense graphs whose weights fit into this many bits are summed through
+   bit planes in auto mode. */
+#define PLANES_MAX 4
+
+/* Graphs with at most this many nodes fit into two words and are solved
+   by the fixed width path in auto mode. */
+#define FIXED_MAX 128
+
+/* Graphs with more nodes than this keep only the compact triangular
+   matrices. */
+#define DENSE_MAX 16384
+
+/* Maximal number of undecided nodes handled by leaf_kernel(). */
+#define LEAF_MAX 16
+
+/* Maximal weighted degree of a node for gains, sparse and dense rows,
+   bit planes and their kernels, which keep sums over neighbours of one
+   node in int. Twice the weight of an edge has to fit there too. Graphs
+   with heavier nodes are searched through the triangular matrices with
+   sums in weight_t. */
+#define WDEG_MAX (INT_MAX / 2)
+
+/* Type of weights of cuts, sums over all edges of a cut do not fit
+   into int. */
+typedef long long weight_t;
+#define WEIGHT_MAX LLONG_MAX
+#define MPI_WEIGHT MPI_LONG_LONG_INT
+
+/* Maximal total weight of edges, a cut and twice the weight of an edge
+   fit into weight_t. */
+#define WTOTAL_MAX (WEIGHT_MAX / 2)
+
 #define TOKEN_BLACK 'B'
 #define TOKEN_WHITE 'W'
 #define TOKEN_NONE 'N'
@@ -107,57 +160,248 @@ struct _stkelem_t
 {
   int uptodate;
   /* Weight of this cut. */
-  int weight;
+  weight_t weight;
+  /* Weight of edges between already decided nodes of X and nodes of
+     Y. No cut generated from this element can be lighter. */
+  weight_t bound;
   /* Offset of the rightmost 1 in the future new element
-     generated from this element.*/
+     generated from this element. With dynamic branching it is only
+     the node moved to Y last, numbered from 1. */
   unsigned next;
   /* Representation of X and Y sets. */
   bitmap_t * set;
+  /* Decided nodes and number of undecided ones with dynamic branching,
+     done is NULL otherwise. */
+  bitmap_t * done;
+  unsigned undecided;
+  /* Gains of nodes, i.e. changes of weight of cut caused by moving
+     each node from X to Y. They always reflect set. */
+  int * gain;
+  /* Storage of gain followed by set, see stkelem_alloc(). */
+  int mem[];
 };
 typedef struct _stkelem_t stkelem_t;
 
 
+/* Number of stack elements allocated at once by stkelem_alloc(). */
+#define SLAB_ELEMS 256
+
+
+/* Entry of undo log, one for each level of DFS tree on the current
+   path when running with single working set. */
+struct _undoent_t
+{
+  /* Node moved to Y on this level. */
+  unsigned node;
+  /* Change of weight of cut caused by moving the node. */
+  weight_t delta;
+  /* Committed weight of this level, see stkelem_t. */
+  weight_t bound;
+  /* Offset of the node moved to Y by the next child of this level. */
+  unsigned next;
+};
+typedef struct _undoent_t undoent_t;
+
+
 /* Number of nodes. */
 unsigned N = 0;
-/* Stack for DFS algorithm. */
-list_t * stack;
-/* */
-trimatrix_t * graph;
-/* Matrix of edges' weights. */
-wtrimatrix_t * weights;
+/* Stack for DFS algorithm, its top is the deepest element. */
+deque_t * stack;
+/* Adjacency matrix and matrix of edges' weights, NULL when adj is
+   used. */
+trimatrix_t * graph = NULL;
+wtrimatrix_t * weights = NULL;
+/* Sparse representation of graph, NULL when the matrices are scanned
+   on hot paths. */
+csr_t * adj = NULL;
+/* Weights of edges as full matrix stored by rows and weighted degrees
+   of nodes, used on hot paths when adj is NULL. Zero weight means
+   there is no edge. */
+sqmatrix_t * wrows = NULL;
+int * wdeg;
+/* Bit sliced weights used for sums over sets of nodes, NULL when they
+   are not used. Requires wrows. */
+wplanes_t * planes = NULL;
+/* Some node has weighted degree above WDEG_MAX. Only the triangular
+   matrices are scanned then and gains are not kept. */
+int wideweights = 0;
+/* Representation of graph for hot paths: 'a'uto, 'd'ense, 's'parse,
+   'p'lanes or 'f'ixed width. */
+char repr = 'a';
 /* Best solution. */
 stkelem_t * best;
+/* Keep gains of nodes in stack elements. The fixed width path computes
+   each delta from bit planes of one or two words instead. */
+int usegains = 1;
+/* Take weights of edges from input instead of random ones. */
+int inweights = 0;
+/* Input is list of edges instead of adjacency matrix. */
+int inedges = 0;
+/* Order nodes are decided in: 'n'one (input order), by weighted
+   'd'egree or 'b'readth first search. */
+char order = 'b';
+/* Algorithm finding the cut: exhaustive 'd'fs, 's'toer-Wagner,
+   'p'arallel contractions or 'k'arger-Stein. */
+char engine = 'd';
+/* Number of worker threads of the parallel engine, 0 for one per
+   online processor. */
+unsigned threads = 0;
+/* Allowed probability that Karger-Stein engine misses the minimum
+   cut. */
+double failure = 0.01;
+/* Seed of random numbers, the same on all processes. */
+unsigned long seed;
+/* Input label of each node after relabelling, NULL when nodes are
+   kept in input order. */
+unsigned * label = NULL;
+/* Reduce graph to a kernel before search. */
+int usereduce = 1;
+/* Node of the kernel containing each input node, NULL when the graph
+   was not reduced, and number of input nodes. */
+unsigned * group = NULL;
+unsigned N0;
+/* Lightest trivial cut found by the reduction, its side is over input
+   nodes. */
+weight_t kweight = WEIGHT_MAX;
+bitmap_t * kside = NULL;
 /* Rank of a process. */
 int rank;
 /* Size of the world. */
 int worldsize;
+/* Pin node 1 to set X so that a cut and its complement are not both
+   enumerated. */
+int pinfirst = 1;
+/* Subtrees with at most this many undecided nodes are walked in Gray
+   code order by gray_walk() instead of being expanded. */
+unsigned graybits = 0;
+/* Subtrees with at most this many undecided nodes are enumerated by
+   leaf_kernel(). */
+unsigned leafbits = 8;
+/* Run DFS on a single working set with undo log instead of stack of
+   cloned elements. */
+int useundo = 0;
+/* Branch on the undecided node with the heaviest edges to decided
+   nodes instead of the next one in order. */
+int dynbranch = 0;
+/* Enumerate only connected sets Y, each from its lowest node. Requires
+   dynbranch. */
+int connected = 0;
+/* Explore first the child whose cut is lighter instead of always the
+   one with the branching node in Y. */
+int goodfirst = 1;
+/* Undo log, working set of nodes in Y and weight of its cut. */
+undoent_t * undolog;
+unsigned undodepth = 0;
+bitmap_t * undoset;
+weight_t undoweight;
+int * undogain;
+/* Size of stack elements' blocks in bytes, offsets of set and done in
+   mem and list of free blocks linked through their first bytes. */
+size_t stkelem_bytes = 0;
+size_t stkelem_setoff;
+size_t stkelem_doneoff;
+void * stkelem_free = NULL;
+
+
+void compute_gains (const bitmap_t * set, int * gain);
+weight_t move_node (const bitmap_t * set, int * gain, unsigned node);
+void decided_weights (const bitmap_t * set, const bitmap_t * done,
+                      unsigned node, weight_t * toy, weight_t * tox);
+
+
+/**
+   Takes block of stack element out of the free list, the list is refilled
+   with a new slab of SLAB_ELEMS blocks when it is empty. Gains, set and
+   done of width N of the element live in the block, their values are
+   undefined.
+   Slabs are never returned to the system.
+   @return stack element or NULL
+*/
+stkelem_t *
+stkelem_alloc (void)
+{
+  stkelem_t * se;
+
+  if (! stkelem_free)
+    {
+      const size_t align = sizeof (bitmap_word_t) > sizeof (void *)
+        ? sizeof (bitmap_word_t) : sizeof (void *);
+      char * slab;
+      unsigned i;
+
+      if (stkelem_bytes == 0)
+        {
+          stkelem_setoff = usegains
+            ? (N * sizeof (int) + align - 1) / align * align : 0;
+          stkelem_doneoff = stkelem_setoff
+            + (bitmap_footprint (N) + align - 1) / align * align;
+          stkelem_bytes = offsetof (stkelem_t, mem) + stkelem_doneoff
+            + (dynbranch ? bitmap_footprint (N) : 0);
+          stkelem_bytes = (stkelem_bytes + align - 1) / align * align;
+        }
+      slab = malloc (SLAB_ELEMS * stkelem_bytes);
+      if (! slab)
+        return NULL;
+      for (i = 0; i < SLAB_ELEMS; ++i)
+        {
+          *(void **)(slab + i * stkelem_bytes) = stkelem_free;
+          stkelem_free = slab + i * stkelem_bytes;
+        }
+    }
+  se = stkelem_free;
+  stkelem_free = *(void **)se;
+  se->gain = usegains ? se->mem : NULL;
+  se->set = bitmap_place ((char *)se->mem + stkelem_setoff, N);
+  se->done = dynbranch
+    ? bitmap_place ((char *)se->mem + stkelem_doneoff, N) : NULL;
+  return se;
+}
+
+
+/**
+   Returns block of stack element into the free list.
+   @param se stack element
+*/
+void
+stkelem_release (stkelem_t * se)
+{
+  *(void **)se = stkelem_free;
+  stkelem_free = se;
+}
 
 
 /**
    Initializes new DFS stack element.
-   @param se pointer to stack element
+   @param se pointer to stack element allocated by stkelem_alloc()
    @param width width of bitmap/set
    @param weight weight of cut in this step
    @param rightmost offset of the rightmost 1 in bitmap/set
    @param last offset of the last 1 in the last generated element
 */
-inline
+static inline
 stkelem_t *
-stkelem_init (stkelem_t * se, unsigned width, unsigned weight, 
+stkelem_init (stkelem_t * se, unsigned width, weight_t weight, 
               unsigned next, int utd)
 {
-  if (width == 0 || next > width - 1)
+  if (width != bitmap_size (se->set) || next > width - 1)
     abort ();
   
-  se->set = bitmap_new (width);
-  if (! se->set)
-    {
-      free (se);
-      return NULL;
-    }
+  bitmap_clear (se->set);
+  compute_gains (se->set, se->gain);
   se->weight = weight;
+  se->bound = 0;
   se->next = next;
   se->uptodate = utd;
+  if (se->done)
+    {
+      /* Nodes before next are decided as without dynamic branching. */
+      unsigned i;
+
+      bitmap_clear (se->done);
+      for (i = 0; i < next; ++i)
+        bitmap_setbit_fast (se->done, i);
+      se->undecided = width - next;
+    }
   return se;
 }
 
@@ -170,17 +414,17 @@ stkelem_init (stkelem_t * se, unsigned width, unsigned weight,
    @param next offset of the rightmost 1 of future generated element
 */
 stkelem_t * 
-stkelem_new (unsigned width, unsigned weight, unsigned next,
+stkelem_new (unsigned width, weight_t weight, unsigned next,
              int utd)
 {
   stkelem_t * se;
 
-  se = malloc (sizeof (stkelem_t));
+  se = stkelem_alloc ();
   if (! se)
     return NULL;
   if (! stkelem_init (se, width, weight, next, utd))
     {
-      free (se);
+      stkelem_release (se);
       return NULL;
     }
   return se;
@@ -197,41 +441,32 @@ stkelem_clone (const stkelem_t * se)
 {
   stkelem_t * newse;
   
-  newse = malloc (sizeof (stkelem_t));
+  newse = stkelem_alloc ();
   if (! newse)
     return NULL;
-  newse->set = bitmap_clone (se->set);
-  if (! newse->set)
-    {
-      free (newse);
-      return NULL;
-    }
+  bitmap_copy (newse->set, se->set);
+  if (usegains)
+    memcpy (newse->gain, se->gain, N * sizeof (int));
   newse->weight = se->weight;
+  newse->bound = se->bound;
   newse->next = se->next;
   newse->uptodate = se->uptodate;
+  if (se->done)
+    {
+      bitmap_copy (newse->done, se->done);
+      newse->undecided = se->undecided;
+    }
   return newse;
 }
 
 
-/**
-
-*/
-inline
-void 
-stkelem_destroy (const stkelem_t * se)
-{
-  bitmap_delete (se->set);
-}
-
-
 /**
  
 */
 void
 stkelem_delete (stkelem_t * se)
 {
-  stkelem_destroy (se);
-  free (se);
+  stkelem_release (se);
 }
 
 
@@ -241,8 +476,9 @@ stkelem_delete (stkelem_t * se)
 size_t 
 stkelem_serialize_size (const stkelem_t * se)
 {
-  return 2*sizeof (int) + sizeof (unsigned)
-    + bitmap_serialize_size (se->set);
+  return sizeof (int) + 2 * sizeof (weight_t) + sizeof (unsigned)
+    + bitmap_serialize_size (se->set)
+    + (se->done ? bitmap_serialize_size (se->done) : 0);
 }
 
 
@@ -253,20 +489,33 @@ void
 stkelem_serialize (void * buf, size_t size, size_t * pos, stkelem_t * se)
 {
   int ret;
+  /* MPI keeps positions in int. */
+  int ipos = *pos;
+
+  ret = MPI_Pack (&se->uptodate, 1, MPI_INT, buf, size, &ipos,
+                  MPI_COMM_WORLD);
+  if (ret != MPI_SUCCESS)
+    mpierror (ret, "MPI_Pack()");
 
-  ret = MPI_Pack (&se->uptodate, 1, MPI_INT, buf, size, pos, MPI_COMM_WORLD);
+  ret = MPI_Pack (&se->weight, 1, MPI_WEIGHT, buf, size, &ipos,
+                  MPI_COMM_WORLD);
   if (ret != MPI_SUCCESS)
     mpierror (ret, "MPI_Pack()");
 
-  ret = MPI_Pack (&se->weight, 1, MPI_INT, buf, size, pos, MPI_COMM_WORLD);
+  ret = MPI_Pack (&se->bound, 1, MPI_WEIGHT, buf, size, &ipos,
+                  MPI_COMM_WORLD);
   if (ret != MPI_SUCCESS)
     mpierror (ret, "MPI_Pack()");
 
-  ret = MPI_Pack (&se->next, 1, MPI_UNSIGNED, buf, size, pos, MPI_COMM_WORLD);
+  ret = MPI_Pack (&se->next, 1, MPI_UNSIGNED, buf, size, &ipos,
+                  MPI_COMM_WORLD);
   if (ret != MPI_SUCCESS)
     mpierror (ret, "MPI_Pack()");
+  *pos = ipos;
   
   bitmap_serialize (buf, size, pos, se->set);
+  if (se->done)
+    bitmap_serialize (buf, size, pos, se->done);
 }
 
 
@@ -278,32 +527,42 @@ stkelem_deserialize (void * buf, size_t insize, size_t * pos)
 {
   stkelem_t * se;
   int ret;
+  /* MPI keeps positions in int. */
+  int ipos = *pos;
 
-  se = malloc (sizeof (stkelem_t));
+  se = stkelem_alloc ();
   if (! se)
     return NULL;
 
-  ret = MPI_Unpack (buf, insize, pos, &se->uptodate, 1, MPI_INT, 
+  ret = MPI_Unpack (buf, insize, &ipos, &se->uptodate, 1, MPI_INT, 
+                    MPI_COMM_WORLD);
+  if (ret != MPI_SUCCESS)
+    mpierror (ret, "MPI_Unpack()");
+
+  ret = MPI_Unpack (buf, insize, &ipos, &se->weight, 1, MPI_WEIGHT, 
                     MPI_COMM_WORLD);
   if (ret != MPI_SUCCESS)
     mpierror (ret, "MPI_Unpack()");
 
-  ret = MPI_Unpack (buf, insize, pos, &se->weight, 1, MPI_INT, 
+  ret = MPI_Unpack (buf, insize, &ipos, &se->bound, 1, MPI_WEIGHT, 
                     MPI_COMM_WORLD);
   if (ret != MPI_SUCCESS)
     mpierror (ret, "MPI_Unpack()");
 
-  ret = MPI_Unpack (buf, insize, pos, &se->next, 1, MPI_UNSIGNED, 
+  ret = MPI_Unpack (buf, insize, &ipos, &se->next, 1, MPI_UNSIGNED, 
                     MPI_COMM_WORLD);
   if (ret != MPI_SUCCESS)
     mpierror (ret, "MPI_Unpack()");
+  *pos = ipos;
 
-  se->set = bitmap_deserialize (buf, insize, pos);
-  if (! se->set)
+  bitmap_deserialize_into (se->set, buf, insize, pos);
+  if (se->done)
     {
-      free (se);
-      return NULL;
+      bitmap_deserialize_into (se->done, buf, insize, pos);
+      se->undecided = N - bitmap_count (se->done);
     }
+  /* Gains are not transferred, they are rebuilt from the set. */
+  compute_gains (se->set, se->gain);
   
   return se;
 }
@@ -330,14 +589,20 @@ void pack_simple_msg (void * buf, size_t size, size_t * pos, char msg_type)
 }
 
 
-void pack_bweight_msg (void * buf, size_t size, size_t * pos, int bweight)
+void pack_bweight_msg (void * buf, size_t size, size_t * pos,
+                       weight_t bweight)
 {
   int ret;
 
+  int ipos;
+
   pack_type (buf, size, pos, TYPE_BWEIGHT);
-  ret = MPI_Pack (&bweight, 1, MPI_INT, buf, size, pos, MPI_COMM_WORLD);
+  /* MPI keeps positions in int. */
+  ipos = *pos;
+  ret = MPI_Pack (&bweight, 1, MPI_WEIGHT, buf, size, &ipos, MPI_COMM_WORLD);
   if (ret != MPI_SUCCESS)
     mpierror (ret, "MPI_Pack()");
+  *pos = ipos;
 }
 
 
@@ -410,13 +675,38 @@ char unpack_char (void * buf, size_t insize, size_t * pos)
 void 
 initialize_stack (void)
 {
-  stkelem_t * el = stkelem_new (N, 0, 0, 1);
+  /* With node 1 pinned to X the root element has it already decided. */
+  stkelem_t * el;
+  unsigned r;
+  weight_t toy, tox;
   
   fprintf (stderr, "[%d] initializing stack\n", rank);
-  if (! el)
-    error ("Memory allocation failure");
-  if (! list_pushback (stack, el))
-    error ("list_pushback()");
+  if (! connected)
+    {
+      el = stkelem_new (N, 0, pinfirst && N > 1 ? 1 : 0, 1);
+      if (! el)
+        error ("Memory allocation failure");
+      if (! deque_pushback (stack, el))
+        error ("deque_pushback()");
+      return;
+    }
+  /* One root element for each lowest node r of connected Y, nodes
+     before it are in X. Larger subtrees of lower roots go to the
+     bottom, they are given away first. */
+  for (r = N; r > (pinfirst ? 1u : 0u); --r)
+    {
+      el = stkelem_new (N, 0, r - 1, 0);
+      if (! el)
+        error ("Memory allocation failure");
+      decided_weights (el->set, el->done, r, &toy, &tox);
+      el->bound = tox;
+      bitmap_setbit_fast (el->done, r - 1);
+      el->undecided -= 1;
+      move_node (el->set, el->gain, r);
+      el->next = r;
+      if (! deque_pushback (stack, el))
+        error ("deque_pushback()");
+    }
 }
 
 
@@ -427,7 +717,7 @@ void
 initialize (void)
 {
   /* Best solution. */
-  best = stkelem_new (N, INT_MAX, 0, 1);  
+  best = stkelem_new (N, WEIGHT_MAX, 0, 1);  
   /* Receive buffer. */
   recv_buf_len = 1 + stkelem_serialize_size (best) + 1000 /*rezerva :)*/;
   recv_buf = malloc (recv_buf_len);
@@ -436,6 +726,15 @@ initialize (void)
   /*weights_buf = malloc (1 + wtrimatrix_serialize_size (weights));*/
   if (!best || ! recv_buf /*|| ! graph_buf || ! weights_buf*/)
     error ("Memory allocation failure");
+  /* Working state of undo log DFS. */
+  if (useundo)
+    {
+      undolog = malloc ((N + 1) * sizeof (undoent_t));
+      undoset = bitmap_new (N);
+      undogain = malloc (N * sizeof (int));
+      if (! undolog || ! undoset || ! undogain)
+        error ("Memory allocation failure");
+    }
   /* The rest. */
   if (rank == 0)
     token = TOKEN_WHITE;
@@ -470,52 +769,166 @@ initialize_mpi (int * argc, char *** argv, int * rank, int * size)
 
 
 /**
-   Updates weight of cut when we move one node from set X to Y.
-   @param el element of DFS tree to update
-   @return true if the cut has weight 1, false otherwise
+   Computes change of weight of cut when we move one node from set X to Y.
+   @param set representation of X and Y sets
+   @param node node (numbered from 1)
+   @return change of weight of the cut
 */
-int 
-update_weight (stkelem_t * el, unsigned node)
+weight_t
+move_delta (const bitmap_t * set, unsigned node)
 {
   unsigned i;
-  int ret;
+  weight_t delta = 0;
 
-  if (node == 0)
-    abort ();
-  if (el->uptodate)
+  if (adj)
     {
-      fprintf (stderr, "[%d] trying to update up-to-date stack element\n", 
-               rank);
-      abort ();
+      const unsigned * nbr;
+      const int * wt;
+      const unsigned deg = csr_row (adj, node, &nbr, &wt);
+
+      for (i = 0; i < deg; ++i)
+        if (bitmap_getbit_fast (set, nbr[i]-1))
+          delta -= wt[i];
+        else
+          delta += wt[i];
+      return delta;
     }
+  if (planes)
+    return wdeg[node-1]
+      - 2 * (int)wplanes_sum (planes, node, bitmap_words (set), N);
+  if (wrows)
+    /* Edges to Y are subtracted and edges to X are added. */
+    return wdeg[node-1] - 2 * masked_sum (sqmatrix_row_fast (wrows, node),
+                                          bitmap_words (set), N);
 
   /* Add/substract weight of edges to/from current */
   for (i = 1; i <= N; ++i)
     {
       if (i == node)
         continue;
-      if (trimatrix_get (graph, node, i))
+      if (trimatrix_get_fast (graph, node, i))
         {
           /* Is node i in set Y? */
-          /*fprintf (stderr, "[%d] N=%d, i=%d, bitmap_size(el->set)=%d\n", 
-            rank, N, i, bitmap_size (el->set));*/
-          if (bitmap_getbit (el->set, i-1))
+          if (bitmap_getbit_fast (set, i-1))
             /* Substract weight of edges whose end nodes are now
                both in Y from the weight of the cut. */
-            el->weight -= wtrimatrix_get (weights, node, i);
+            delta -= (weight_t)wtrimatrix_get_fast (weights, node, i);
           else
             /* Add weight of edges whose end nodes are now one in
                the set X and the other in the set Y. */
-            el->weight += wtrimatrix_get (weights, node, i);
+            delta += (weight_t)wtrimatrix_get_fast (weights, node, i);
         }
     }
-  
-  el->uptodate = 1;
+  return delta;
+}
+
+
+/**
+   Computes gains of all nodes from scratch.
+   @param set representation of X and Y sets
+   @param gain array of N gains to fill
+*/
+void
+compute_gains (const bitmap_t * set, int * gain)
+{
+  unsigned i;
+
+  if (! usegains)
+    return;
+  for (i = 1; i <= N; ++i)
+    gain[i-1] = move_delta (set, i);
+}
+
+
+/**
+   Returns gain of node, from gains if they are kept.
+   @param set representation of X and Y sets
+   @param gain gains of nodes
+   @param node node (numbered from 1)
+   @return change of weight of cut caused by moving node from X to Y
+*/
+static inline
+weight_t
+node_gain (const bitmap_t * set, const int * gain, unsigned node)
+{
+  return usegains ? gain[node-1] : move_delta (set, node);
+}
+
+
+/**
+   Moves node between sets X and Y and updates gains of its neighbours.
+   Gain of the node itself does not change.
+   @param set representation of X and Y sets
+   @param gain gains of nodes
+   @param node node (numbered from 1)
+   @return change of weight of cut
+*/
+weight_t
+move_node (const bitmap_t * set, int * gain, unsigned node)
+{
+  const int toy = ! bitmap_flipbit_fast (set, node-1);
+  unsigned i;
+  int w2;
+
+  if (! usegains)
+    {
+      /* Gain of node does not depend on its own side. */
+      const weight_t delta = move_delta (set, node);
+
+      return toy ? delta : -delta;
+    }
+  if (adj)
+    {
+      const unsigned * nbr;
+      const int * wt;
+      const unsigned deg = csr_row (adj, node, &nbr, &wt);
+
+      for (i = 0; i < deg; ++i)
+        {
+          w2 = 2 * wt[i];
+          gain[nbr[i]-1] += toy ? -w2 : w2;
+        }
+    }
+  else if (wrows)
+    {
+      const int * row = sqmatrix_row_fast (wrows, node);
+      const int sign = toy ? -2 : 2;
+
+      for (i = 0; i < N; ++i)
+        gain[i] += sign * row[i];
+    }
+  else
+    for (i = 1; i <= N; ++i)
+      {
+        if (i == node)
+          continue;
+        if (trimatrix_get_fast (graph, node, i))
+          {
+            w2 = 2 * wtrimatrix_get_fast (weights, node, i);
+            gain[i-1] += toy ? -w2 : w2;
+          }
+      }
+  return toy ? gain[node-1] : -gain[node-1];
+}
+
+
+/**
+   Makes copy of el the best solution if it is better than the current
+   one and announces it to other processes.
+   @param el element of DFS tree with up-to-date weight
+   @return true if the cut has weight 1, false otherwise
+*/
+int
+update_best (const stkelem_t * el)
+{
+  int i, ret;
+
   if (el->weight < best->weight && el->weight > 0)
     {
       size_t pos = 0;
 
-      fprintf (stderr, "[%d] got better solution than current best %d < %d\n",
+      fprintf (stderr,
+               "[%d] got better solution than current best %lld < %lld\n",
               rank, el->weight, best->weight);
       stkelem_delete (best);
       best = stkelem_clone (el);
@@ -556,21 +969,245 @@ update_weight (stkelem_t * el, unsigned node)
 }
 
 
+/**
+   Updates weight of cut when we move one node from set X to Y.
+   @param el element of DFS tree to update
+   @return true if the cut has weight 1, false otherwise
+*/
+int 
+update_weight (stkelem_t * el, unsigned node)
+{
+  if (node == 0)
+    abort ();
+  if (el->uptodate)
+    {
+      fprintf (stderr, "[%d] trying to update up-to-date stack element\n", 
+               rank);
+      abort ();
+    }
+
+  /* Gains already reflect node in Y and its own gain does not depend
+     on that. */
+  el->weight += node_gain (el->set, el->gain, node);
+  el->uptodate = 1;
+  return update_best (el);
+}
+
+
+/**
+   Sums weights of edges between node and already decided nodes.
+   @param set representation of X and Y sets
+   @param done decided nodes, NULL when they are all nodes before node
+   @param node node (numbered from 1)
+   @param toy weight of edges from node to set Y
+   @param tox weight of edges from node to decided part of set X
+*/
+void
+decided_weights (const bitmap_t * set, const bitmap_t * done, unsigned node,
+                 weight_t * toy, weight_t * tox)
+{
+  unsigned i;
+
+  *toy = 0;
+  *tox = 0;
+  if (done)
+    {
+      /* Nodes of Y are all decided, the rest of done is in X. */
+      if (adj)
+        {
+          const unsigned * nbr;
+          const int * wt;
+          const unsigned deg = csr_row (adj, node, &nbr, &wt);
+
+          for (i = 0; i < deg; ++i)
+            if (bitmap_getbit_fast (set, nbr[i]-1))
+              *toy += wt[i];
+            else if (bitmap_getbit_fast (done, nbr[i]-1))
+              *tox += wt[i];
+        }
+      else if (planes)
+        {
+          *toy = wplanes_sum (planes, node, bitmap_words (set), N);
+          *tox = wplanes_sum (planes, node, bitmap_words (done), N) - *toy;
+        }
+      else if (wrows)
+        {
+          const int * row = sqmatrix_row_fast (wrows, node);
+
+          *toy = masked_sum (row, bitmap_words (set), N);
+          *tox = masked_sum (row, bitmap_words (done), N) - *toy;
+        }
+      else
+        for (i = 1; i <= N; ++i)
+          if (i != node && bitmap_getbit_fast (done, i-1)
+              && trimatrix_get_fast (graph, node, i))
+            {
+              if (bitmap_getbit_fast (set, i-1))
+                *toy += wtrimatrix_get_fast (weights, node, i);
+              else
+                *tox += wtrimatrix_get_fast (weights, node, i);
+            }
+      return;
+    }
+  if (adj)
+    {
+      const unsigned * nbr;
+      const int * wt;
+      const unsigned deg = csr_row (adj, node, &nbr, &wt);
+
+      /* Neighbours are sorted, stop at the first undecided one. */
+      for (i = 0; i < deg && nbr[i] < node; ++i)
+        if (bitmap_getbit_fast (set, nbr[i]-1))
+          *toy += wt[i];
+        else
+          *tox += wt[i];
+      return;
+    }
+  if (planes)
+    {
+      *toy = wplanes_sum (planes, node, bitmap_words (set), node - 1);
+      *tox = wplanes_sum (planes, node, NULL, node - 1) - *toy;
+      return;
+    }
+  if (wrows)
+    {
+      const int * row = sqmatrix_row_fast (wrows, node);
+
+      *toy = masked_sum (row, bitmap_words (set), node - 1);
+      for (i = 0; i < node - 1; ++i)
+        *tox += row[i];
+      *tox -= *toy;
+      return;
+    }
+  for (i = 1; i < node; ++i)
+    if (trimatrix_get_fast (graph, node, i))
+      {
+        if (bitmap_getbit_fast (set, i-1))
+          *toy += wtrimatrix_get_fast (weights, node, i);
+        else
+          *tox += wtrimatrix_get_fast (weights, node, i);
+      }
+}
+
+
+/**
+   Returns number of undecided nodes of element.
+*/
+static inline
+unsigned
+undecided_count (const stkelem_t * el)
+{
+  return el->done ? el->undecided : N - el->next;
+}
+
+
+/**
+   Lists undecided nodes of element in ascending order.
+   @param el element
+   @param nodes array to fill with nodes numbered from 0
+   @return number of the nodes
+*/
+static
+unsigned
+undecided_nodes (const stkelem_t * el, unsigned * nodes)
+{
+  unsigned i, count = 0;
+
+  if (! el->done)
+    {
+      for (i = el->next; i < N; ++i)
+        nodes[count++] = i;
+      return count;
+    }
+  for (i = 0; i < N; ++i)
+    if (! bitmap_getbit_fast (el->done, i))
+      nodes[count++] = i;
+  return count;
+}
+
+
+/**
+   Picks undecided node to branch on, the one with the heaviest edges
+   to decided nodes. Both of its children then commit as much weight
+   as possible, which tightens bound the most. Only neighbours of Y
+   are considered when enumerating connected sets.
+   @param el element with dynamic branching and undecided nodes
+   @param toy weight of edges from the node to set Y
+   @param tox weight of edges from the node to decided part of set X
+   @return the node, numbered from 0, or N if there is none
+*/
+unsigned
+branch_node (const stkelem_t * el, weight_t * toy, weight_t * tox)
+{
+  unsigned i, node = N;
+  weight_t y, x, max = -1;
+
+  for (i = 0; i < N; ++i)
+    {
+      if (bitmap_getbit_fast (el->done, i))
+        continue;
+      decided_weights (el->set, el->done, i + 1, &y, &x);
+      if (connected && y == 0)
+        continue;
+      if (y + x > max)
+        {
+          max = y + x;
+          node = i;
+          *toy = y;
+          *tox = x;
+        }
+    }
+  return node;
+}
+
+
 /**
    Generates next level of DFS tree from element el and pushes it 
-   at the end of list.
+   at the end of list. Children whose committed weight already
+   reaches the weight of the best solution are skipped. The pushed
+   element has the branching node in Y and el goes on with it in X,
+   unless reorder is set and the cut with the node in X is lighter,
+   then the roles are swapped and el takes the node to Y. Either of
+   them may be out of date afterwards.
+   @param list list to push to
    @param el element
+   @param reorder push the lighter child
    @return true if the next element was successfully generated,
    false otherwise.
 */
 int
-generate_depth (list_t * list, stkelem_t * el)
+generate_depth (deque_t * list, stkelem_t * el, int reorder)
 {
   stkelem_t * newel;
+  weight_t toy, tox;
+  weight_t newbound;
+  unsigned node;
 
-  /* Is it possible to go deeper in DFS tree? */
-  if (el->next < N)
+  /* Is it possible and worth it to go deeper in DFS tree? */
+  while (undecided_count (el) != 0 && el->bound < best->weight)
     {
+      if (el->done)
+        {
+          node = branch_node (el, &toy, &tox);
+          if (node == N)
+            /* No undecided neighbour of connected Y. */
+            return 0;
+          bitmap_setbit_fast (el->done, node);
+          el->undecided -= 1;
+        }
+      else
+        {
+          node = el->next;
+          decided_weights (el->set, NULL, node + 1, &toy, &tox);
+          el->next += 1;
+        }
+      /* Node goes to Y in the new element and it stays in X in all
+         elements generated later from el. */
+      newbound = el->bound + tox;
+      el->bound += toy;
+      if (newbound >= best->weight)
+        continue;
+
       /* el:    [1 0 0 ... 0]
          |        
          v        
@@ -578,66 +1215,419 @@ generate_depth (list_t * list, stkelem_t * el)
       newel = stkelem_clone (el);
       if (! newel)
         error ("Memory allocation failure");
-      bitmap_setbit (newel->set, el->next);
-      newel->next = el->next + 1;
-      el->next += 1;
-      newel->uptodate = 0;
+      if (reorder && el->bound < best->weight
+          && node_gain (el->set, el->gain, node + 1) > 0)
+        {
+          /* Moving the node to Y makes the cut heavier, newel keeps
+             it in X and is explored first. */
+          move_node (el->set, el->gain, node + 1);
+          el->next = node + 1;
+          el->bound = newbound;
+          el->uptodate = 0;
+        }
+      else
+        {
+          move_node (newel->set, newel->gain, node + 1);
+          newel->next = node + 1;
+          newel->bound = newbound;
+          newel->uptodate = 0;
+        }
       /* Push newel onto DFS stack. */
-      if (! list_push (list, newel))
-        error ("list_push()");
+      if (! deque_push (list, newel))
+        error ("deque_push()");
       return 1;
     }
-  else
-    return 0;
+  return 0;
 }
 
 
-void 
-end_computation (void)
+/**
+   Returns offset of the lowest 1 bit of non-zero x.
+*/
+static inline
+unsigned
+lowest_bit (unsigned long x)
 {
-  int i;
-  size_t pos = 0;
-  FILE * output = stdout;
+#ifdef __GNUC__
+  return __builtin_ctzl (x);
+#else
+  unsigned i = 0;
 
-  if (rank != 0)
-    error ("end_computation() called by rank != 0");
+  while (! (x & 1ul))
+    {
+      x >>= 1;
+      ++i;
+    }
+  return i;
+#endif
+}
 
-  /* Prepare the message. */
-  pack_simple_msg (recv_buf, recv_buf_len, &pos, MSG_EOC);
-  fprintf (stderr, "[%d] sending MSG_EOC to processor", rank);
-  /* End of computation. */
-  for (i = 1; i < worldsize; ++i)
+
+/**
+   Walks all subsets of undecided nodes of element el in reflected Gray
+   code order. Every step moves exactly one node between X and Y, the
+   weight of cut is updated from its gain and only the gains of its
+   neighbours are refreshed. The element is used as the working state,
+   nothing is allocated per step.
+   @param el up-to-date element of DFS tree, it is consumed by the walk
+   @return true if a cut of weight 1 has been found, false otherwise
+*/
+int
+gray_walk (stkelem_t * el)
+{
+  unsigned nodes[sizeof (unsigned long) * CHAR_BIT];
+  const unsigned long last = 1ul << undecided_nodes (el, nodes);
+  unsigned long step;
+  unsigned node;
+
+  for (step = 1; step < last; ++step)
     {
-      int ret;
+      /* Step number step of reflected Gray code flips bit at the
+         position of the lowest 1 in step. */
+      node = nodes[lowest_bit (step)];
+      el->weight += move_node (el->set, el->gain, node + 1);
+      if (update_best (el))
+        return 1;
+    }
+  return 0;
+}
 
-      ret = MPI_Send (recv_buf, pos, MPI_PACKED, i, TAG_NEEDS_ATTENTION, 
-                      MPI_COMM_WORLD); 
-      if (ret != MPI_SUCCESS)
-        mpierror (ret, "MPI_Send()");
-      fprintf (stderr, " %d", i);
+
+/**
+   Enumerates all subsets of undecided nodes of element el, at most
+   LEAF_MAX of them, in Gray code order. Deltas of all undecided nodes
+   are taken from their gains and weights of edges among them are
+   fetched once up front, each step then only adjusts the small delta
+   vector in a fixed length loop. The vector is kept in int, weighted
+   degrees of nodes must not exceed WDEG_MAX.
+   Only the lightest cut found is reported.
+   @param el up-to-date element of DFS tree, it is consumed
+   @return true if a cut of weight 1 has been found, false otherwise
+*/
+int
+leaf_kernel (stkelem_t * el)
+{
+  unsigned nodes[LEAF_MAX];
+  const unsigned undecided = undecided_nodes (el, nodes);
+  const unsigned last = 1u << undecided;
+  int delta[LEAF_MAX], w2[LEAF_MAX][LEAF_MAX];
+  weight_t weight = el->weight, minweight = WEIGHT_MAX;
+  unsigned step, mask = 0, minmask = 0, j, l, v;
+
+  /* Precompute deltas of moving each undecided node to Y and doubled
+     weights of edges between undecided nodes. */
+  memset (delta, 0, sizeof (delta));
+  memset (w2, 0, sizeof (w2));
+  for (j = 0; j < undecided; ++j)
+    {
+      const unsigned node = nodes[j] + 1;
+
+      delta[j] = node_gain (el->set, el->gain, node);
+      if (adj && ! el->done)
+        {
+          const unsigned * nbr;
+          const int * wt;
+          const unsigned deg = csr_row (adj, node, &nbr, &wt);
+
+          for (l = 0; l < deg; ++l)
+            if (nbr[l] > el->next)
+              w2[j][nbr[l] - el->next - 1] = 2 * wt[l];
+        }
+      else if (adj)
+        {
+          const unsigned * nbr;
+          const int * wt;
+          const unsigned deg = csr_row (adj, node, &nbr, &wt);
+          unsigned k = 0;
+
+          /* Both neighbours and undecided nodes are sorted. */
+          for (l = 0; l < deg; ++l)
+            {
+              while (k < undecided && nodes[k] + 1 < nbr[l])
+                ++k;
+              if (k == undecided)
+                break;
+              if (nodes[k] + 1 == nbr[l])
+                w2[j][k] = 2 * wt[l];
+            }
+        }
+      else if (wrows)
+        {
+          const int * row = sqmatrix_row_fast (wrows, node);
+
+          for (l = 0; l < undecided; ++l)
+            w2[j][l] = 2 * row[nodes[l]];
+        }
+      else
+        for (l = 0; l < undecided; ++l)
+          if (l != j && trimatrix_get_fast (graph, node, nodes[l] + 1))
+            w2[j][l] = 2 * wtrimatrix_get_fast (weights, node,
+                                                nodes[l] + 1);
+    }
+
+  for (step = 1; step < last; ++step)
+    {
+      v = lowest_bit (step);
+      if (mask & (1u << v))
+        {
+          /* Node v goes back to X. */
+          weight -= delta[v];
+          for (l = 0; l < LEAF_MAX; ++l)
+            delta[l] += w2[v][l];
+        }
+      else
+        {
+          /* Node v goes to Y. */
+          weight += delta[v];
+          for (l = 0; l < LEAF_MAX; ++l)
+            delta[l] -= w2[v][l];
+        }
+      mask ^= 1u << v;
+      if (weight < minweight && weight > 0)
+        {
+          minweight = weight;
+          minmask = mask;
+        }
+    }
+
+  if (minweight >= best->weight)
+    return 0;
+  for (j = 0; j < undecided; ++j)
+    if (minmask & (1u << j))
+      move_node (el->set, el->gain, nodes[j] + 1);
+  el->weight = minweight;
+  return update_best (el);
+}
+
+
+/**
+   Makes stack element the bottom level of undo log. 
+   @param el element of DFS tree, it is deleted
+   @return true if the cut has weight 1, false otherwise
+*/
+int
+undo_load (stkelem_t * el)
+{
+  int ret = 0;
+
+  if (! el->uptodate)
+    ret = update_weight (el, el->next);
+  bitmap_copy (undoset, el->set);
+  if (usegains)
+    memcpy (undogain, el->gain, N * sizeof (int));
+  undoweight = el->weight;
+  undolog[0].node = 0;
+  undolog[0].delta = 0;
+  undolog[0].bound = el->bound;
+  undolog[0].next = el->next;
+  undodepth = 1;
+  stkelem_delete (el);
+  return ret;
+}
+
+
+/**
+   Makes one step of DFS on the working set. It either descends to the
+   next child of the deepest level, finishes its small subtree as a
+   whole or backtracks from it.
+   @return true if a cut of weight 1 has been found, false otherwise
+*/
+int
+undo_step (void)
+{
+  undoent_t * top = &undolog[undodepth - 1];
+  stkelem_t view;
+  weight_t toy, tox, newbound;
+  int ret;
+  unsigned node;
+
+  view.uptodate = 1;
+  view.weight = undoweight;
+  view.bound = top->bound;
+  view.next = top->next;
+  view.set = undoset;
+  view.gain = undogain;
+  view.done = NULL;
+
+  /* Finish small enough subtree as a whole. */
+  if (top->next < N && top->bound < best->weight
+      && (N - top->next <= leafbits || N - top->next <= graybits))
+    {
+      if (N - top->next <= leafbits)
+        ret = leaf_kernel (&view);
+      else
+        ret = gray_walk (&view);
+      /* Undecided nodes are all in X again. */
+      for (node = top->next; node < N; ++node)
+        if (bitmap_getbit_fast (undoset, node))
+          move_node (undoset, undogain, node + 1);
+      top->next = N;
+      return ret;
+    }
+
+  /* Descend to the next child. */
+  while (top->next < N && top->bound < best->weight)
+    {
+      node = top->next;
+      decided_weights (undoset, NULL, node + 1, &toy, &tox);
+      newbound = top->bound + tox;
+      top->bound += toy;
+      top->next += 1;
+      if (newbound >= best->weight)
+        continue;
+
+      top += 1;
+      top->node = node;
+      top->delta = move_node (undoset, undogain, node + 1);
+      top->bound = newbound;
+      top->next = node + 1;
+      undoweight += top->delta;
+      undodepth += 1;
+
+      view.weight = undoweight;
+      view.bound = top->bound;
+      view.next = top->next;
+      return update_best (&view);
+    }
+
+  /* Backtrack. */
+  if (undodepth > 1)
+    {
+      move_node (undoset, undogain, top->node + 1);
+      undoweight -= top->delta;
+    }
+  undodepth -= 1;
+  return 0;
+}
+
+
+/**
+   Tells whether the bottom level of undo log has a child left to try.
+   The level stays in the log with next == N until it is backtracked.
+   @return true if undo_bottom() has children to give away
+*/
+int
+undo_bottom_open (void)
+{
+  return undodepth > 0 && undolog[0].next < N;
+}
+
+
+/**
+   Materializes the bottom level of undo log as stack element.
+   @return new element of DFS tree
+*/
+stkelem_t *
+undo_bottom (void)
+{
+  stkelem_t * el;
+  unsigned i;
+
+  el = stkelem_new (N, undoweight, undolog[0].next, 1);
+  if (! el)
+    error ("Memory allocation failure");
+  bitmap_copy (el->set, undoset);
+  if (usegains)
+    memcpy (el->gain, undogain, N * sizeof (int));
+  for (i = undodepth - 1; i > 0; --i)
+    {
+      move_node (el->set, el->gain, undolog[i].node + 1);
+      el->weight -= undolog[i].delta;
+    }
+  el->bound = undolog[0].bound;
+  return el;
+}
+
+
+/**
+   Prints the best solution with nodes of sets X and Y under their input
+   labels. The trivial cut found by the reduction is printed when no
+   lighter cut was found.
+*/
+void
+print_best (void)
+{
+  int i;
+  bitmap_t * set;
+  weight_t weight = best->weight;
+  FILE * output = stdout;
+
+  /* Map the solution back to input labels of nodes. */
+  set = best->set;
+  if (label)
+    {
+      set = bitmap_new (N);
+      if (! set)
+        error ("Memory allocation failure");
+      for (i = 0; i < N; ++i)
+        if (bitmap_getbit (best->set, i))
+          bitmap_setbit (set, label[i] - 1);
+    }
+  if (kside && kweight <= weight)
+    {
+      set = kside;
+      weight = kweight;
+    }
+  else if (group)
+    {
+      bitmap_t * kernelset = set;
+
+      set = bitmap_new (N0);
+      if (! set)
+        error ("Memory allocation failure");
+      for (i = 0; i < N0; ++i)
+        if (bitmap_getbit (kernelset, group[i] - 1))
+          bitmap_setbit (set, i);
     }
-  fprintf (stderr, "\n");
 
   /* Print out the solution. */
-  fprintf (output, "\nWeight of the best solution: %d\n", best->weight);
+  fprintf (output, "\nWeight of the best solution: %lld\n", weight);
   fprintf (output, "Set X:");
-  for (i = 0; i < bitmap_size (best->set); ++i)
+  for (i = 0; i < bitmap_size (set); ++i)
     {
-      int b = bitmap_getbit (best->set, i);
+      int b = bitmap_getbit (set, i);
       if (! b)
         fprintf (output, " %d", i+1);
     }
   fprintf (output, "\n");
   fprintf (output, "Set Y:");
-  for (i = 0; i < bitmap_size (best->set); ++i)
+  for (i = 0; i < bitmap_size (set); ++i)
     {
-      int b = bitmap_getbit (best->set, i);
+      int b = bitmap_getbit (set, i);
       if (b)
         fprintf (output, " %d", i+1);
     }
   fprintf (output, "\n");
   fflush (output);
+}
+
+
+void 
+end_computation (void)
+{
+  int i;
+  size_t pos = 0;
+
+  if (rank != 0)
+    error ("end_computation() called by rank != 0");
 
+  /* Prepare the message. */
+  pack_simple_msg (recv_buf, recv_buf_len, &pos, MSG_EOC);
+  fprintf (stderr, "[%d] sending MSG_EOC to processor", rank);
+  /* End of computation. */
+  for (i = 1; i < worldsize; ++i)
+    {
+      int ret;
+
+      ret = MPI_Send (recv_buf, pos, MPI_PACKED, i, TAG_NEEDS_ATTENTION, 
+                      MPI_COMM_WORLD); 
+      if (ret != MPI_SUCCESS)
+        mpierror (ret, "MPI_Send()");
+      fprintf (stderr, " %d", i);
+    }
+  fprintf (stderr, "\n");
+
+  print_best ();
   MPI_Finalize ();
   exit (EXIT_SUCCESS);
 }
@@ -666,6 +1656,9 @@ do_tokens ()
     {
       if (token != TOKEN_NONE)
         {
+          /* Work might have been given away since the token arrived. */
+          if (mycolor == TOKEN_BLACK)
+            token = TOKEN_BLACK;
           /* Prepare the message. */
           pack_token_msg (recv_buf, recv_buf_len, &pos, token);
           /* Send my token to the next process. */
@@ -688,11 +1681,10 @@ void process_message (void * buf, size_t insize);
 void 
 process_work_request (int from)
 {
-  listelem_t * it;
   stkelem_t * el;
+  stkelem_t ** give;
   unsigned half;
   int i, ret, j=0;
-  list_t * tmplist;
 
   fprintf (stderr, "[%d] received work request from %d\n", rank, from);
  
@@ -700,7 +1692,7 @@ process_work_request (int from)
      Do we have anything to give? 
      Do we want to give at all?
   */
-  if (list_size (stack) == 0 || ! wouldgive)
+  if ((deque_size (stack) == 0 && ! undo_bottom_open ()) || ! wouldgive)
     {
       size_t pos = 0;
 
@@ -716,38 +1708,69 @@ process_work_request (int from)
       return;
     }
   /* We have something to give. */
-  tmplist = list_new ();
-  if (! tmplist)
-    error ("Memory allocation failure.");
-  el = list_last (stack, &it);
-  if (! el->uptodate)
-    update_weight (el, el->next);
-  half = (N - el->next) / 2;
+  if (deque_size (stack) > 1)
+    {
+      /* Give away the bottom half of stack at once, its elements are
+         the largest subtrees. The top element stays. */
+      half = deque_size (stack) / 2;
+      give = malloc (half * sizeof (stkelem_t *));
+      if (! give)
+        error ("Memory allocation failure.");
+      half = deque_take (stack, (void **)give, half);
+    }
+  else
+    {
+      deque_t * tmp;
+
+      tmp = deque_new ();
+      if (! tmp)
+        error ("Memory allocation failure.");
+      if (deque_size (stack) != 0)
+        {
+          el = deque_bottom (stack);
+          if (! el->uptodate)
+            update_weight (el, el->next);
+        }
+      else
+        /* Give away children of the bottom level of undo log. */
+        el = undo_bottom ();
+      half = undecided_count (el) / 2;
+      /* Generate the half. */
+      fprintf (stderr, "[%d] generating %d new stack elements\n",
+               rank, half);
+      for (i = 1; i <= half; ++i)
+        generate_depth (tmp, el, 0);
+      if (deque_size (stack) == 0)
+        {
+          undolog[0].next = el->next;
+          undolog[0].bound = el->bound;
+          stkelem_delete (el);
+        }
+      half = deque_size (tmp);
+      give = malloc ((half + 1) * sizeof (stkelem_t *));
+      if (! give)
+        error ("Memory allocation failure.");
+      deque_take (tmp, (void **)give, half);
+      deque_delete (tmp);
+    }
   if (half != 0 && rank > from)
     /* Change token. */
     mycolor = TOKEN_BLACK;
-  /* Generate the half. */
-  fprintf (stderr, "[%d] generating %d new stack elements\n",
-          rank, half);
-  for (i = 1; i <= half; ++i)
-    generate_depth (tmplist, el);
   /* Send the half to requester. */
-  while (list_size (tmplist) != 0)
+  for (i = 0; i < (int)half; ++i)
     {
-      stkelem_t * tmpel;
       size_t pos = 0;
-                
-      tmpel = list_popback (tmplist);
-      pack_stkelem_msg (recv_buf, recv_buf_len, &pos, tmpel);
+
+      pack_stkelem_msg (recv_buf, recv_buf_len, &pos, give[i]);
       fprintf (stderr, "[%d] sending generated stack element %d to %d\n",
               rank, ++j, from);
       ret = MPI_Send (recv_buf, pos, MPI_PACKED, from, TAG_NEEDS_ATTENTION,
                       MPI_COMM_WORLD);
       if (ret != MPI_SUCCESS)
         mpierror (ret, "MPI_Send()");
-      stkelem_delete (tmpel);
+      stkelem_delete (give[i]);
     }
-  list_delete (tmplist);
+  free (give);
   /* Send MSG_EOE to requester. */
   {
     size_t pos = 0; 
@@ -903,9 +1926,11 @@ request_donor (void)
 void request_work (int from)
 {
   int ret, j=0;
-  size_t pos = 0;
+  size_t pos;
 
+ again:
   /* Send the request. */
+  pos = 0;
   pack_simple_msg (recv_buf, recv_buf_len, &pos, MSG_REQ);
   fprintf (stderr, "[%d] sending request for work to %d\n", rank, from);
   ret = MPI_Send (recv_buf, pos, MPI_PACKED, from, TAG_NEEDS_ATTENTION, 
@@ -956,17 +1981,18 @@ void request_work (int from)
                       dnr = donor;
                       donor = (donor + 1) % worldsize;
                     }
-                  if (dnr != rank)
-                    /* Send request to obtained donor and read results. */
-                    request_work (dnr);
-                  //continue;
-                  /* Request a new donor from 0. */
-                  //dnr = request_donor ();
-                  /* Send request to obtained donor and read results. */
-                  //request_work (dnr);
+                  /* A token received while waiting for the donor is
+                     passed on, the ring must not stall on an idle
+                     process that keeps getting itself as donor. */
+                  if (dnr == rank && rank != 0)
+                    do_tokens ();
                 }
               while (dnr == rank);
-              return;
+              /* Send request to obtained donor and read results. Not
+                 a recursive call, an idle process can be denied for
+                 as long as the computation runs. */
+              from = dnr;
+              goto again;
 
             default:
               fprintf (stderr, "[%d] processing clamour message from %d"
@@ -979,8 +2005,8 @@ void request_work (int from)
           se = stkelem_deserialize (recv_buf, recv_buf_len, &pos);
           if (! se)
             error ("Memory allocation problem.");
-          if (! list_pushback (stack, se))
-            error ("list_pushback()");
+          if (! deque_pushback (stack, se))
+            error ("deque_pushback()");
           fprintf (stderr, "[%d] received stack element %d from %d\n",
                    rank, ++j, from);
           continue;
@@ -1023,7 +2049,7 @@ process_best (void * buf, size_t insize, size_t * pos)
       fprintf (stderr, "[%d] received 'best' that"
                " is worse than its 'best'!!!\n", rank);
     }
-  fprintf (stderr, "[0] received new best stack element, weight=%d\n",
+  fprintf (stderr, "[0] received new best stack element, weight=%lld\n",
           best->weight);
 }
 
@@ -1058,11 +2084,14 @@ process_message (void * buf, size_t insize)
 
     case TYPE_BWEIGHT:
       {
-        int w;
+        weight_t w;
+        /* MPI keeps positions in int. */
+        int ipos = inpos;
         
         if (rank == 0)
           error ("Message TYPE_BWEIGHT received by process 0.");
-        ret = MPI_Unpack (buf, insize, &inpos, &w, 1, MPI_INT, MPI_COMM_WORLD);
+        ret = MPI_Unpack (buf, insize, &ipos, &w, 1, MPI_WEIGHT,
+                          MPI_COMM_WORLD);
         if (ret != MPI_SUCCESS)
           mpierror (ret, "MPI_Unpack");
         if (w < best->weight)
@@ -1070,7 +2099,7 @@ process_message (void * buf, size_t insize)
         else
           fprintf (stderr, "[%d] received 'best' weight"
                   " that is worse than its 'best'!!!\n", rank);
-        fprintf (stderr, "[%d] received new best weight=%d\n", rank, 
+        fprintf (stderr, "[%d] received new best weight=%lld\n", rank, 
                  best->weight);
         return;
       }
@@ -1082,61 +2111,755 @@ process_message (void * buf, size_t insize)
 }
 
 
+/**
+   Reports input that cannot be searched and ends the program. Every
+   process has read the same input and ends with it.
+   @param msg description of the problem
+*/
+void
+input_error (const char * msg)
+{
+  if (rank == 0)
+    fprintf (stderr, "mrg: %s\n", msg);
+  MPI_Finalize ();
+  exit (EXIT_FAILURE);
+}
+
+
+/**
+   Reads adjacency matrix of N nodes into graph and weights. Non-zero
+   values are edges, they are also their weights with -w.
+   @param infile input file positioned after the number of nodes
+*/
+void
+read_matrix (FILE * infile)
+{
+  unsigned i, j;
+  int ret;
+  weight_t total = 0;
+
+  graph = trimatrix_new (N);
+  weights = wtrimatrix_new (N);
+  if (! graph || ! weights)
+    error ("Memory allocation failure");
+  for (i = 1; i <= N; ++i)
+    for (j = 1; j <= N; ++j)
+      {
+        unsigned long long val;
+        ret = fscanf (infile, "%llu", &val);
+        if (ret < 1)
+          error ("fscanf()");
+        trimatrix_set (graph, i, j, val != 0);
+        if (! val)
+          continue;
+        if (! inweights)
+          val = random () % 255 + 1;
+        if (val > WTOTAL_MAX)
+          input_error ("Total weight of edges is too large.");
+        /* Storage is widened only as far as the weights require. */
+        if (! wtrimatrix_fit (weights, val))
+          error ("Memory allocation failure");
+        wtrimatrix_set (weights, i, j, val);
+      }
+  for (i = 1; i <= N; ++i)
+    {
+      weight_t deg = 0;
+
+      for (j = 1; j <= N; ++j)
+        {
+          const weight_t w = j != i ? wtrimatrix_get (weights, i, j) : 0;
+
+          /* Edges to later nodes are counted into total once. */
+          if (j > i && w > WTOTAL_MAX - total)
+            input_error ("Total weight of edges is too large.");
+          if (j > i)
+            total += w;
+          deg += w;
+        }
+      if (deg > WDEG_MAX)
+        wideweights = 1;
+    }
+}
+
+
+/**
+   Reads list of edges of graph of N nodes into adj without building
+   the matrices. The list starts with the number of edges followed by
+   triples of two end nodes and a weight, which is used only with -w.
+   Memory stays O(N + M). Graphs with nodes of weighted degree above
+   WDEG_MAX go into the matrices instead, parallel edges are summed.
+   @param infile input file positioned after the number of nodes
+*/
+void
+read_edges (FILE * infile)
+{
+  unsigned long long m, val;
+  size_t e;
+  unsigned * ends;
+  wvalue_t * wval;
+  weight_t * deg, total = 0;
+  unsigned x, y;
+  int ret;
+
+  ret = fscanf (infile, "%llu", &m);
+  if (ret < 1)
+    error ("fscanf()");
+  if (N == 0 || m > SIZE_MAX / (2 * sizeof (unsigned)))
+    error ("Bad size of graph.");
+  ends = malloc ((m ? m : 1) * 2 * sizeof (unsigned));
+  wval = malloc ((m ? m : 1) * sizeof (wvalue_t));
+  deg = calloc (N, sizeof (weight_t));
+  if (! ends || ! wval || ! deg)
+    error ("Memory allocation failure");
+  for (e = 0; e < m; ++e)
+    {
+      ret = fscanf (infile, "%u %u %llu", &x, &y, &val);
+      if (ret < 3)
+        error ("fscanf()");
+      if (x == 0 || y == 0 || x > N || y > N)
+        error ("Edge with node out of range.");
+      if (! inweights)
+        val = random () % 255 + 1;
+      /* Loops do not cross any cut. */
+      if (x != y)
+        {
+          if (val > (unsigned long long)(WTOTAL_MAX - total))
+            input_error ("Total weight of edges is too large.");
+          total += val;
+          deg[x-1] += val;
+          deg[y-1] += val;
+          if (deg[x-1] > WDEG_MAX || deg[y-1] > WDEG_MAX)
+            wideweights = 1;
+        }
+      ends[2*e] = x;
+      ends[2*e+1] = y;
+      wval[e] = val;
+    }
+  if (wideweights)
+    {
+      graph = trimatrix_new (N);
+      weights = wtrimatrix_new (N);
+      if (! graph || ! weights)
+        error ("Memory allocation failure");
+      for (e = 0; e < m; ++e)
+        {
+          x = ends[2*e];
+          y = ends[2*e+1];
+          if (x == y)
+            continue;
+          val = wtrimatrix_get (weights, x, y) + wval[e];
+          if (! wtrimatrix_fit (weights, val))
+            error ("Memory allocation failure");
+          trimatrix_set (graph, x, y, 1);
+          wtrimatrix_set (weights, x, y, val);
+        }
+    }
+  else
+    {
+      int * wt = malloc ((m ? m : 1) * sizeof (int));
+
+      if (! wt)
+        error ("Memory allocation failure");
+      for (e = 0; e < m; ++e)
+        wt[e] = (int)wval[e];
+      adj = csr_from_edges (N, m, ends, wt);
+      if (! adj)
+        error ("Memory allocation failure");
+      free (wt);
+    }
+  free (ends);
+  free (wval);
+  free (deg);
+}
+
+
+/* Weighted degrees of nodes for compare_degree(). */
+static const long * order_deg;
+
+
+/**
+   Orders nodes by descending weighted degree, ties by their labels.
+*/
+static
+int
+compare_degree (const void * a, const void * b)
+{
+  const unsigned x = *(const unsigned *)a, y = *(const unsigned *)b;
+
+  if (order_deg[x-1] != order_deg[y-1])
+    return order_deg[x-1] > order_deg[y-1] ? -1 : 1;
+  return x < y ? -1 : x > y;
+}
+
+
+/**
+   Computes order of nodes for relabelling.
+   @param g graph
+   @param seq array of N nodes to fill, seq[i] is the node that gets
+   label i+1
+*/
+void
+order_nodes (const csr_t * g, unsigned * seq)
+{
+  long * deg;
+  unsigned char * seen;
+  unsigned i, x, head, tail, root;
+  const unsigned * nbr;
+  const int * wt;
+  unsigned d, k;
+
+  deg = malloc (N * sizeof (long));
+  if (! deg)
+    error ("Memory allocation failure");
+  for (x = 1; x <= N; ++x)
+    {
+      d = csr_row (g, x, &nbr, &wt);
+      deg[x-1] = 0;
+      for (k = 0; k < d; ++k)
+        deg[x-1] += wt[k];
+    }
+  order_deg = deg;
+  for (i = 0; i < N; ++i)
+    seq[i] = i + 1;
+  qsort (seq, N, sizeof (unsigned), compare_degree);
+  if (order == 'b')
+    {
+      /* Cuthill-McKee like search from the heaviest node of each
+         component, neighbours are queued heaviest first. seq keeps
+         nodes by degree, the search order is built in place of its
+         copy. */
+      unsigned * bydeg = malloc (N * sizeof (unsigned));
+
+      seen = calloc (N, 1);
+      if (! bydeg || ! seen)
+        error ("Memory allocation failure");
+      memcpy (bydeg, seq, N * sizeof (unsigned));
+      head = tail = 0;
+      for (root = 0; root < N; ++root)
+        {
+          if (seen[bydeg[root]-1])
+            continue;
+          seen[bydeg[root]-1] = 1;
+          seq[tail++] = bydeg[root];
+          while (head < tail)
+            {
+              const unsigned first = tail;
+
+              d = csr_row (g, seq[head++], &nbr, &wt);
+              for (k = 0; k < d; ++k)
+                if (! seen[nbr[k]-1])
+                  {
+                    seen[nbr[k]-1] = 1;
+                    seq[tail++] = nbr[k];
+                  }
+              qsort (seq + first, tail - first, sizeof (unsigned),
+                     compare_degree);
+            }
+        }
+      free (bydeg);
+      free (seen);
+    }
+  free (deg);
+}
+
+
+/**
+   Reduces graph read from input to a kernel by reduce_graph(), the
+   kernel replaces the graph and group maps its nodes back for
+   print_best(). Every node contracted away halves the work of the DFS.
+   The lightest trivial cut is kept even when nothing is contracted, it
+   bounds the search. The graph is kept when a node of the kernel is
+   too heavy for the DFS.
+*/
+void
+reduce_input (void)
+{
+  csr_t * g = adj, * kernel;
+  const unsigned * nbr;
+  const int * wt;
+  unsigned i, j, n, deg;
+  int heavy = 0;
+
+  if (! g)
+    {
+      g = csr_new (graph, weights, N);
+      if (! g)
+        error ("Memory allocation failure");
+    }
+  group = malloc (N * sizeof (unsigned));
+  kside = bitmap_new (N);
+  if (! group || ! kside)
+    error ("Memory allocation failure");
+  kernel = reduce_graph (g, group, kside, &kweight);
+  if (! kernel)
+    error ("Memory allocation failure");
+  n = csr_nodes (kernel);
+  for (i = 1; i <= n && ! heavy; ++i)
+    {
+      long long sum = 0;
+
+      deg = csr_row (kernel, i, &nbr, &wt);
+      for (j = 0; j < deg; ++j)
+        sum += wt[j];
+      heavy = sum > WDEG_MAX;
+    }
+  fprintf (stderr, "[%d] reduced graph from %u to %u nodes, lightest "
+           "trivial cut %lld\n", rank, N, heavy ? N : n, kweight);
+  if (g != adj)
+    csr_delete (g);
+  if (heavy || n == N)
+    {
+      csr_delete (kernel);
+      free (group);
+      group = NULL;
+      return;
+    }
+  if (adj)
+    csr_delete (adj);
+  else
+    {
+      trimatrix_delete (graph);
+      wtrimatrix_delete (weights);
+      graph = NULL;
+      weights = NULL;
+    }
+  adj = kernel;
+  N0 = N;
+  N = n;
+}
+
+
+/**
+   Relabels nodes of graph read from input so that they are decided in
+   the order chosen by option -o. Heavy nodes decided early make the
+   committed weight of stack elements grow fast, neighbours labelled
+   close to each other keep row scans local. Input labels are kept in
+   label for end_computation().
+*/
+void
+relabel_graph (void)
+{
+  csr_t * g = adj;
+  unsigned * pos;
+  unsigned i;
+
+  if (! g)
+    {
+      g = csr_new (graph, weights, N);
+      if (! g)
+        error ("Memory allocation failure");
+    }
+  label = malloc (N * sizeof (unsigned));
+  pos = malloc (N * sizeof (unsigned));
+  if (! label || ! pos)
+    error ("Memory allocation failure");
+  order_nodes (g, label);
+  for (i = 0; i < N; ++i)
+    pos[label[i]-1] = i + 1;
+  if (adj)
+    {
+      adj = csr_permute (g, pos);
+      if (! adj)
+        error ("Memory allocation failure");
+    }
+  else
+    {
+      trimatrix_t * newgraph = trimatrix_permute (graph, pos);
+      wtrimatrix_t * newweights = wtrimatrix_permute (weights, pos);
+
+      if (! newgraph || ! newweights)
+        error ("Memory allocation failure");
+      trimatrix_delete (graph);
+      wtrimatrix_delete (weights);
+      graph = newgraph;
+      weights = newweights;
+    }
+  csr_delete (g);
+  free (pos);
+}
+
+
+/**
+   Finds the minimum cut by one of the polynomial engines, prints it and
+   ends the program. Polynomial time makes them usable far beyond sizes
+   of graphs the DFS can enumerate.
+*/
+void
+solve_polynomial (void)
+{
+  csr_t * g = adj;
+  long long weight;
+  int ret;
+
+  if (! g)
+    {
+      g = csr_new (graph, weights, N);
+      if (! g)
+        error ("Memory allocation failure");
+    }
+  best = stkelem_new (N, WEIGHT_MAX, 0, 1);
+  if (! best)
+    error ("Memory allocation failure");
+  if (engine == 's')
+    {
+      fprintf (stderr, "[%d] using Stoer-Wagner engine\n", rank);
+      ret = sw_mincut (g, best->set, &weight);
+    }
+  else
+    {
+      if (threads == 0)
+        {
+          long online = sysconf (_SC_NPROCESSORS_ONLN);
+
+          threads = online > 0 ? (unsigned)online : 1;
+        }
+      fprintf (stderr, "[%d] using parallel engine with %u threads\n", rank,
+               threads);
+      ret = pmc_mincut (g, threads, best->set, &weight);
+    }
+  if (! ret)
+    error ("Memory allocation failure");
+  best->weight = weight;
+  if (g != adj)
+    csr_delete (g);
+  print_best ();
+  MPI_Finalize ();
+  exit (EXIT_SUCCESS);
+}
+
+
+/**
+   Finds the minimum cut by trials of Karger-Stein algorithm spread over
+   all processes, prints it from rank 0 and ends the program. Every
+   process runs its share of trials with its own seeds, the lightest
+   cut is picked by MPI_Allreduce() with MPI_MINLOC and its side is
+   broadcast from the process that found it.
+*/
+void
+solve_karger_stein (void)
+{
+  csr_t * g = adj;
+  long long weight;
+  struct
+  {
+    long value;
+    int rank;
+  } mine, lightest;
+  void * buf;
+  size_t pos = 0, size;
+  int ret;
+
+  if (! g)
+    {
+      g = csr_new (graph, weights, N);
+      if (! g)
+        error ("Memory allocation failure");
+    }
+  best = stkelem_new (N, WEIGHT_MAX, 0, 1);
+  if (! best)
+    error ("Memory allocation failure");
+  if (rank == 0)
+    fprintf (stderr, "[%d] using Karger-Stein engine, %lu trials on %d "
+             "processes\n", rank, ks_trials (N, failure), worldsize);
+  if (! ks_mincut (g, failure, seed, rank, worldsize, best->set, &weight))
+    error ("Memory allocation failure");
+  best->weight = weight;
+  if (g != adj)
+    csr_delete (g);
+
+  /* Pick the lightest cut of all processes. */
+  mine.value = weight < LONG_MAX ? (long)weight : LONG_MAX;
+  mine.rank = rank;
+  ret = MPI_Allreduce (&mine, &lightest, 1, MPI_LONG_INT, MPI_MINLOC,
+                       MPI_COMM_WORLD);
+  if (ret != MPI_SUCCESS)
+    mpierror (ret, "MPI_Allreduce()");
+  size = bitmap_serialize_size (best->set);
+  buf = malloc (size);
+  if (! buf)
+    error ("Memory allocation failure");
+  if (rank == lightest.rank)
+    bitmap_serialize (buf, size, &pos, best->set);
+  ret = MPI_Bcast (buf, size, MPI_PACKED, lightest.rank, MPI_COMM_WORLD);
+  if (ret != MPI_SUCCESS)
+    mpierror (ret, "MPI_Bcast()");
+  if (rank == 0)
+    {
+      pos = 0;
+      bitmap_deserialize_into (best->set, buf, size, &pos);
+      best->weight = lightest.value == LONG_MAX ? WEIGHT_MAX
+        : lightest.value;
+      print_best ();
+    }
+  free (buf);
+  MPI_Finalize ();
+  exit (EXIT_SUCCESS);
+}
+
+
 int 
 main (int argc, char * argv[])
 {
-  int ret;
+  int ret, opt;
   unsigned i, j;
   FILE * infile;
 
 
   initialize_mpi (&argc, &argv, &rank, &worldsize);
   /* Some basic checks and initialization. */
-  if (argc < 2)
+  while ((opt = getopt (argc, argv, "audcywexg:k:r:o:m:t:p:")) != -1)
+    switch (opt)
+      {
+      case 'a':
+        /* Enumerate both a cut and its complement. */
+        pinfirst = 0;
+        break;
+
+      case 'u':
+        useundo = 1;
+        break;
+
+      case 'd':
+        dynbranch = 1;
+        break;
+
+      case 'c':
+        connected = 1;
+        dynbranch = 1;
+        break;
+
+      case 'y':
+        /* Always explore the child with the branching node in Y
+           first. */
+        goodfirst = 0;
+        break;
+
+      case 'w':
+        /* Values of input matrix are weights of edges. */
+        inweights = 1;
+        break;
+
+      case 'e':
+        inedges = 1;
+        break;
+
+      case 'x':
+        /* Search the whole graph. */
+        usereduce = 0;
+        break;
+
+      case 'o':
+        order = optarg[0];
+        if (order != 'n' && order != 'd' && order != 'b')
+          error (USAGE);
+        break;
+
+      case 'm':
+        engine = optarg[0];
+        if (engine != 'd' && engine != 's' && engine != 'p'
+            && engine != 'k')
+          error (USAGE);
+        break;
+
+      case 'p':
+        failure = strtod (optarg, NULL);
+        if (! (failure > 0 && failure < 1))
+          error ("Probability of failure has to be between 0 and 1.");
+        break;
+
+      case 't':
+        threads = strtoul (optarg, NULL, 10);
+        break;
+
+      case 'g':
+        graybits = strtoul (optarg, NULL, 10);
+        if (graybits >= sizeof (unsigned long) * CHAR_BIT)
+          error ("Too many bits for Gray code walk.");
+        break;
+
+      case 'k':
+        leafbits = strtoul (optarg, NULL, 10);
+        if (leafbits > LEAF_MAX)
+          error ("Too many bits for leaf kernel.");
+        break;
+
+      case 'r':
+        repr = optarg[0];
+        if (repr != 'a' && repr != 'd' && repr != 's' && repr != 'p'
+            && repr != 'f')
+          error (USAGE);
+        break;
+
+      default:
+        error (USAGE);
+      }
+  if (dynbranch && useundo)
+    error ("Dynamic branching cannot be combined with undo log.");
+  if (optind >= argc)
     {
       fprintf (stderr, "Pocet argumentu: %d\n", argc);
       for (i = 0; i < argc; ++i)
         fprintf (stderr, "`%s'\n", argv[i]);
-      error ("Syntax: mrg <input graph>");
+      error (USAGE);
+    }
+  /* Random weights and trials of Karger-Stein engine have to be the
+     same on all processes. */
+  seed = time (NULL);
+  ret = MPI_Bcast (&seed, 1, MPI_UNSIGNED_LONG, 0, MPI_COMM_WORLD);
+  if (ret != MPI_SUCCESS)
+    mpierror (ret, "MPI_Bcast()");
+  srandom (seed);
+  /* Polynomial engines but Karger-Stein run on rank 0 alone. */
+  if (engine != 'd' && engine != 'k' && rank != 0)
+    {
+      MPI_Finalize ();
+      exit (EXIT_SUCCESS);
     }
-  srandom (time (NULL));
   
   /* Open input file and read graph's dimension. */
-  fprintf (stderr, "File to open: %s\n", argv[argc-1]); 
-  infile = fopen (argv[argc-1], "r");
+  fprintf (stderr, "File to open: %s\n", argv[optind]); 
+  infile = fopen (argv[optind], "r");
   if (! infile)
     error ("fopen()");
   ret = fscanf (infile, "%u", &N);
   if (ret < 1)
     error ("fscanf()");
   
-  /* Allocate structures. */
-  stack = list_new ();
-  graph = trimatrix_new (N);
-  weights = wtrimatrix_new (N);
-  if (! stack || ! graph || ! weights)
+  stack = deque_new ();
+  if (! stack)
     error ("Memory allocation failure");
-  
   /* Read graph from file. */
-  for (i = 1; i <= N; ++i)
-    for (j = 1; j <= N; ++j)
-      {
-        unsigned val;
-        ret = fscanf (infile, "%u", &val);
-        if (ret < 1)
-          error ("fscanf()");
-        trimatrix_set (graph, i, j, val);
-        if (val)
-          wtrimatrix_set (weights, i, j, random () % 255 + 1);
-      }
+  if (inedges)
+    read_edges (infile);
+  else
+    read_matrix (infile);
+  fclose (infile);
+  if (wideweights)
+    {
+      /* Reduction, relabelling, the other engines, the leaf kernel and
+         all but the triangular matrices keep sums over neighbours in
+         int. Deltas are computed from the matrices instead of kept in
+         gains. */
+      if (engine != 'd')
+        input_error ("Nodes of weighted degree 2^30 and more are searched"
+                     " only by -m dfs.");
+      fprintf (stderr, "[%d] weighted degree of a node exceeds %d, "
+               "searching the matrices with 64-bit sums\n", rank, WDEG_MAX);
+      usereduce = 0;
+      order = 'n';
+      repr = 'd';
+      usegains = 0;
+      leafbits = 0;
+    }
+  if (usereduce && N > 0)
+    reduce_input ();
+  /* Nothing is left to search when the graph or the kernel has no
+     edges or no cut can be lighter than the trivial one. */
+  if (kweight == 1 || (kside && kweight == WEIGHT_MAX)
+      || (group && csr_edges (adj) == 0))
+    {
+      if (rank == 0)
+        {
+          best = stkelem_new (N, WEIGHT_MAX, 0, 1);
+          if (! best)
+            error ("Memory allocation failure");
+          print_best ();
+        }
+      MPI_Finalize ();
+      exit (EXIT_SUCCESS);
+    }
+  if (order != 'n')
+    relabel_graph ();
+  if (engine == 'k')
+    solve_karger_stein ();
+  if (engine != 'd')
+    solve_polynomial ();
+
+  /* Pick representation of graph scanned on hot paths. */
+  if (repr == 'a' && N > 0 && N <= FIXED_MAX)
+    repr = 'f';
+  if (repr == 'f' && N > FIXED_MAX)
+    error ("Too many nodes for fixed width path.");
+  if (repr != 'd' && repr != 'p' && repr != 'f' && ! adj)
+    {
+      adj = csr_new (graph, weights, N);
+      if (! adj)
+        error ("Memory allocation failure");
+    }
+  if (adj && (repr == 'd' || repr == 'p' || repr == 'f'
+              || (repr == 'a' && N > 1
+                  && csr_edges (adj) > SPARSE_DENSITY * N * (N - 1) / 2)))
+    {
+      if (! graph)
+        {
+          graph = trimatrix_new (N);
+          weights = wtrimatrix_new (N);
+          if (! graph || ! weights || ! csr_to_matrices (adj, graph, weights))
+            error ("Memory allocation failure");
+        }
+      csr_delete (adj);
+      adj = NULL;
+    }
+  else if (adj && graph)
+    {
+      /* Matrices are not scanned at all with sparse representation. */
+      trimatrix_delete (graph);
+      wtrimatrix_delete (weights);
+      graph = NULL;
+      weights = NULL;
+    }
+  if (! adj && ! wideweights && N > 0 && N <= DENSE_MAX)
+    {
+      /* Dense rows, the triangular matrices are scanned only when they
+         do not fit into memory. */
+      wrows = sqmatrix_from_wtrimatrix (weights);
+      wdeg = malloc (N * sizeof (int));
+      if (wrows && wdeg)
+        for (i = 1; i <= N; ++i)
+          {
+            const int * row = sqmatrix_row (wrows, i);
+
+            wdeg[i-1] = 0;
+            for (j = 0; j < N; ++j)
+              wdeg[i-1] += row[j];
+          }
+      else if (wrows)
+        {
+          sqmatrix_delete (wrows);
+          wrows = NULL;
+        }
+    }
+  if (wrows && (repr == 'p' || repr == 'a' || repr == 'f'))
+    {
+      /* Planes pay off only for narrow weights, rows are kept for
+         updates of gains of single neighbours. */
+      planes = wplanes_new (weights, N);
+      if (planes && repr == 'a' && wplanes_count (planes) > PLANES_MAX)
+        {
+          wplanes_delete (planes);
+          planes = NULL;
+        }
+      /* Sets and rows of planes fit into one or two words, deltas are
+         cheaper to compute than to keep up to date. */
+      if (planes && repr == 'f')
+        usegains = 0;
+    }
+  kernel_init ();
+  fprintf (stderr, "[%d] using %s representation of graph, %s kernels\n",
+           rank, adj ? "sparse" : wideweights ? "64-bit matrix"
+           : ! usegains ? "fixed width"
+           : planes ? "bit planes" : "dense",
+           kernel_name ());
 
   /* Do the actual work here.  */
   initialize ();
+  /* Only cuts lighter than the trivial cut found by the reduction are
+     searched for. */
+  best->weight = kweight;
   /* Synchronize before start of the computation. */
   MPI_Barrier (MPI_COMM_WORLD);
   while (1)
     {
-      listelem_t * it;
       stkelem_t * el;
       int dnr, flag = 0;
 
@@ -1183,7 +2906,7 @@ main (int argc, char * argv[])
         }
 
       /* Are we out of work? */
-      if (list_size (stack) == 0)
+      if (deque_size (stack) == 0 && undodepth == 0)
         {
           fprintf (stderr, "[%d] out of work\n", rank);
           /* Deny any requests for work. */
@@ -1210,7 +2933,20 @@ main (int argc, char * argv[])
           continue;
         }
       
-      el = list_first (stack, &it);
+      /* DFS on the working set. */
+      if (useundo)
+        {
+          ret = 0;
+          if (undodepth == 0)
+            ret = undo_load (deque_pop (stack));
+          if (! ret)
+            ret = undo_step ();
+          if (ret && rank == 0)
+            end_computation ();
+          continue;
+        }
+
+      el = deque_top (stack);
       if (! el)
         {
           fprintf (stderr, "[%d] stack empty even after request for work, exiting\n",
@@ -1228,14 +2964,29 @@ main (int argc, char * argv[])
             else
               continue;
           }
-      if (generate_depth (stack, el))
+      /* Finish small enough subtree as a whole. */
+      if (el->bound < best->weight
+          && (undecided_count (el) <= leafbits
+              || undecided_count (el) <= graybits))
+        {
+          deque_pop (stack);
+          if (undecided_count (el) <= leafbits)
+            ret = leaf_kernel (el);
+          else
+            ret = gray_walk (el);
+          stkelem_delete (el);
+          if (ret && rank == 0)
+            end_computation ();
+          continue;
+        }
+      if (generate_depth (stack, el, goodfirst))
         {
           /* Get the newly generated element. */
-          el = list_first (stack, &it);
+          el = deque_top (stack);
           /* Update weight of a new cut.
              Is this a cut of weight 1? 
              Note: el->next because nodes are numbered from 1. */
-          if (update_weight (el, el->next)) 
+          if (! el->uptodate && update_weight (el, el->next)) 
             /* It is, we are done. */
             {
               if (rank == 0)
@@ -1248,7 +2999,7 @@ main (int argc, char * argv[])
         }
       else
         {
-          stkelem_t * se = list_pop (stack);
+          stkelem_t * se = deque_pop (stack);
           if (se != best)
             stkelem_delete (se);
         }
@@ -0,0 +1,212 @@
+/*
+Copyright (c) 1997-2007, Václav Haisman
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "planes.h"
+
+
+struct _wplanes_t
+{
+  /* Number of nodes. */
+  unsigned n;
+  /* Number of planes, i.e. bits of the heaviest weight. */
+  unsigned count;
+  /* Number of 64 bit words of one row. */
+  unsigned words;
+  /* Plane k of node x starts at ((x-1)*count + k)*words. */
+  uint64_t * buf;
+};
+
+
+static inline
+unsigned
+popcount64 (uint64_t x)
+{
+#ifdef __GNUC__
+  return __builtin_popcountll (x);
+#else
+  x = x - ((x >> 1) & 0x5555555555555555ull);
+  x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+  x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0full;
+  return (unsigned)((x * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+
+/**
+   Slices weights of edges into bit planes.
+   @param weights weights of edges, zero means no edge
+   @param n number of nodes
+   @return new planes or NULL on allocation failure
+*/
+wplanes_t *
+wplanes_new (const wtrimatrix_t * weights, unsigned n)
+{
+  wplanes_t * p;
+  unsigned x, y, k;
+  wvalue_t w, max = 0;
+
+  if (n == 0)
+    abort ();
+  p = malloc (sizeof (wplanes_t));
+  if (! p)
+    return NULL;
+  for (x = 1; x <= n; ++x)
+    for (y = x + 1; y <= n; ++y)
+      if (wtrimatrix_get (weights, x, y) > max)
+        max = wtrimatrix_get (weights, x, y);
+  p->n = n;
+  p->count = 0;
+  while (p->count < sizeof (wvalue_t) * 8 && (max >> p->count) != 0)
+    ++p->count;
+  p->words = (n + 63) / 64;
+  p->buf = calloc ((size_t)n * (p->count ? p->count : 1) * p->words,
+                   sizeof (uint64_t));
+  if (! p->buf)
+    {
+      free (p);
+      return NULL;
+    }
+  for (x = 1; x <= n; ++x)
+    for (y = 1; y <= n; ++y)
+      {
+        if (y == x)
+          continue;
+        w = wtrimatrix_get (weights, x, y);
+        for (k = 0; k < p->count; ++k)
+          if (w & ((wvalue_t)1 << k))
+            p->buf[((size_t)(x - 1) * p->count + k) * p->words + (y - 1) / 64]
+              |= 1ull << ((y - 1) % 64);
+      }
+  return p;
+}
+
+
+/**
+   Frees memory allocated by planes.
+   @param p planes
+*/
+void
+wplanes_delete (wplanes_t * p)
+{
+  free (p->buf);
+  free (p);
+}
+
+
+/**
+   Returns number of bit planes.
+   @param p planes
+   @return number of planes
+*/
+unsigned
+wplanes_count (const wplanes_t * p)
+{
+  return p->count;
+}
+
+
+/**
+   Returns mask of bits of word i of a row that belong to nodes y-1 < nbits.
+*/
+static inline
+uint64_t
+prefix_mask (unsigned i, unsigned nbits)
+{
+  if (nbits >= (i + 1) * 64)
+    return ~0ull;
+  if (nbits <= i * 64)
+    return 0;
+  return (1ull << (nbits % 64)) - 1;
+}
+
+
+/* Defines wplanes_sum_<words>() for rows of exactly words 64 bit words,
+   i.e. for graphs of at most 64*words nodes. The set stays in registers
+   and all loops have constant trip counts. */
+#define WPLANES_SUM_FIXED(words)                                        \
+static inline                                                           \
+unsigned long                                                           \
+wplanes_sum_##words (const wplanes_t * p, unsigned x,                   \
+                     const bitmap_word_t * bits, unsigned nbits)        \
+{                                                                       \
+  const uint64_t * row = p->buf + (size_t)(x - 1) * p->count * words;   \
+  uint64_t y[words];                                                    \
+  unsigned long sum = 0;                                                \
+  unsigned i, k;                                                        \
+                                                                        \
+  for (i = 0; i < words; ++i)                                           \
+    y[i] = (bits ? bits[i] : ~0ull) & prefix_mask (i, nbits);           \
+  for (k = 0; k < p->count; ++k, row += words)                          \
+    for (i = 0; i < words; ++i)                                         \
+      sum += (unsigned long)popcount64 (row[i] & y[i]) << k;            \
+  return sum;                                                           \
+}
+
+WPLANES_SUM_FIXED (1)
+WPLANES_SUM_FIXED (2)
+
+
+/**
+   Sums weights of edges from node x to nodes y-1 < nbits, either all
+   of them or those selected by bits.
+   @param p planes
+   @param x node
+   @param bits words of bitmap_t selecting nodes or NULL for all nodes
+   @param nbits number of nodes taken into account
+   @return sum of weights
+*/
+unsigned long
+wplanes_sum (const wplanes_t * p, unsigned x, const bitmap_word_t * bits,
+             unsigned nbits)
+{
+  const uint64_t * row = p->buf + (size_t)(x - 1) * p->count * p->words;
+  const unsigned words = (nbits + 63) / 64;
+  unsigned long sum = 0;
+  unsigned i, k;
+
+  if (x == 0 || x > p->n || nbits > p->n)
+    abort ();
+  switch (p->words)
+    {
+    case 1:
+      return wplanes_sum_1 (p, x, bits, nbits);
+    case 2:
+      return wplanes_sum_2 (p, x, bits, nbits);
+    }
+  for (i = 0; i < words; ++i)
+    {
+      uint64_t y;
+
+      y = bits ? bits[i] : ~0ull;
+      if (i == words - 1 && nbits % 64 != 0)
+        y &= (1ull << (nbits % 64)) - 1;
+      for (k = 0; k < p->count; ++k)
+        sum += (unsigned long)popcount64 (row[k * p->words + i] & y) << k;
+    }
+  return sum;
+}
@@ -0,0 +1,60 @@
+/*
+Copyright (c) 1997-2007, Václav Haisman
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef _PLANES_H_
+#define _PLANES_H_
+
+#include "config.h"
+#include "gstdint.h"
+#include "matrix.h"
+#include "bitmap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /**
+     Bit sliced weights of edges. For each node x and each bit k of
+     weights there is an N bit row with bit y-1 set when bit k of
+     weight of edge (x,y) is set. Sums of weights over a set of nodes
+     are then computed with popcounts of whole 64 bit words. Nodes are
+     counted from 1.
+  */
+  struct _wplanes_t;
+  typedef struct _wplanes_t wplanes_t;
+
+  extern wplanes_t * wplanes_new (const wtrimatrix_t * weights, unsigned n);
+  extern void wplanes_delete (wplanes_t * p);
+  extern unsigned wplanes_count (const wplanes_t * p);
+  extern unsigned long wplanes_sum (const wplanes_t * p, unsigned x,
+                                    const bitmap_word_t * bits,
+                                    unsigned nbits);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,624 @@
+/*
+Copyright (c) 1997-2007, Václav Haisman
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
+#include "heap.h"
+#include "cgraph_priv.h"
+#include "pmc.h"
+
+
+/* Workers get blocks of at least this many nodes. Blocks of a few
+   nodes contain hardly any edges to contract. */
+#define PMC_BLOCK_MIN 64
+
+/* Levels of clustering and sweeps of label propagation on each level
+   when looking for the initial upper bound. */
+#define PMC_LEVELS 16
+#define PMC_SWEEPS 3
+
+/* No node. */
+#define PMC_NONE UINT_MAX
+
+
+/* Work of one worker thread. */
+struct _pmc_t;
+struct _pmc_job_t
+{
+  struct _pmc_t * p;
+  unsigned id;
+  void (* fn) (struct _pmc_t *, unsigned);
+};
+typedef struct _pmc_job_t pmc_job_t;
+
+
+/* State shared by workers. Each worker owns the nodes of its block
+   and the scratch arrays with its index. */
+struct _pmc_t
+{
+  unsigned threads;
+  unsigned workers;
+  /* Graph being contracted and graph the workers run on. */
+  cgraph_t * g;
+  const cgraph_t * work;
+  /* Number of original nodes and node of g containing each of them. */
+  unsigned n0;
+  unsigned * group;
+  /* Lightest cut found so far and its side. */
+  long long best;
+  bitmap_t * side;
+  /* Nodes of block of worker i are bound[i] ... bound[i+1]-1. */
+  unsigned * bound;
+  /* Scratch of workers. */
+  heap_t ** queue;
+  long long ** acc;
+  unsigned ** touched;
+  /* Pairs of nodes found to be safe to contract by each worker. */
+  unsigned ** pair;
+  size_t * pairs;
+  size_t * pairmax;
+  int * failed;
+  /* Nodes already scanned by the current round. */
+  char * scanned;
+  /* Labels of label propagation, old holds labels of the previous
+     sweep for neighbours in other blocks. */
+  unsigned * label;
+  unsigned * old;
+  /* Threads of workers but the first one. */
+  pthread_t * tid;
+  pmc_job_t * job;
+  int * started;
+};
+typedef struct _pmc_t pmc_t;
+
+
+static
+unsigned
+pmc_find (unsigned * parent, unsigned x)
+{
+  while (parent[x] != x)
+    {
+      parent[x] = parent[parent[x]];
+      x = parent[x];
+    }
+  return x;
+}
+
+
+/**
+   Makes the lightest trivial cut of graph the best one if it is
+   lighter. Nodes without edges are skipped, they make no cut of
+   positive weight.
+   @param p state
+   @param g graph
+   @param group node of g containing each original node
+*/
+static
+void
+pmc_record (pmc_t * p, const cgraph_t * g, const unsigned * group)
+{
+  unsigned v, x, min = PMC_NONE;
+
+  for (v = 0; v < g->n; ++v)
+    if (g->deg[v] > 0 && g->deg[v] < p->best
+        && (min == PMC_NONE || g->deg[v] < g->deg[min]))
+      min = v;
+  if (min == PMC_NONE)
+    return;
+  p->best = g->deg[min];
+  bitmap_clear (p->side);
+  for (x = 0; x < p->n0; ++x)
+    if (group[x] == min)
+      bitmap_setbit (p->side, x);
+}
+
+
+/**
+   Splits nodes of graph into blocks of about the same number of arcs,
+   one for each worker.
+   @param p state
+   @param g graph
+   @param workers number of blocks wanted, fewer are made for small
+   graphs
+*/
+static
+void
+pmc_blocks (pmc_t * p, const cgraph_t * g, unsigned workers)
+{
+  const size_t arcs = g->start[g->n];
+  unsigned i, v = 0;
+
+  if (workers > g->n / PMC_BLOCK_MIN)
+    workers = g->n / PMC_BLOCK_MIN;
+  if (workers == 0)
+    workers = 1;
+  p->workers = workers;
+  p->work = g;
+  p->bound[0] = 0;
+  for (i = 1; i < workers; ++i)
+    {
+      while (v < g->n && g->start[v] < arcs / workers * i)
+        ++v;
+      p->bound[i] = v;
+    }
+  p->bound[workers] = g->n;
+}
+
+
+static
+void
+pmc_pair (pmc_t * p, unsigned id, unsigned v, unsigned u)
+{
+  if (p->pairs[id] == p->pairmax[id])
+    {
+      const size_t max = p->pairmax[id] ? 2 * p->pairmax[id] : 1024;
+      unsigned * pair = realloc (p->pair[id], 2 * max * sizeof (unsigned));
+
+      if (! pair)
+        {
+          p->failed[id] = 1;
+          return;
+        }
+      p->pair[id] = pair;
+      p->pairmax[id] = max;
+    }
+  p->pair[id][2*p->pairs[id]] = v;
+  p->pair[id][2*p->pairs[id]+1] = u;
+  ++p->pairs[id];
+}
+
+
+/**
+   Finds edges of block that are safe to contract. Edge (u,v) with
+   weight w can be contracted if
+
+   - w is at least the weight of the best cut, or
+   - 2w is more than the weighted degree of u or v. Moving that node
+     to the other side of any cut separating u and v makes the cut
+     lighter, unless the node is alone on its side.
+
+   Nodes of the block are then scanned in maximum adjacency order of
+   the subgraph induced by the block, edges whose scanned ends reach
+   weight of at least the best cut are contracted. The connectivity of
+   their ends is at least that, so no lighter cut is lost (CAPFOREST of
+   Nagamochi and Ibaraki, in parallel as in VieCut).
+   @param p state
+   @param id index of worker
+*/
+static
+void
+pmc_scan (pmc_t * p, unsigned id)
+{
+  const cgraph_t * g = p->work;
+  const unsigned lo = p->bound[id], hi = p->bound[id+1];
+  const long long best = p->best;
+  heap_t * q = p->queue[id];
+  unsigned v, u, s;
+  size_t a;
+
+  p->pairs[id] = 0;
+  for (v = lo; v < hi; ++v)
+    for (a = g->start[v]; a < g->start[v+1]; ++a)
+      {
+        const long long w = g->wt[a];
+
+        u = g->nbr[a];
+        if (u > v && (w >= best || 2 * w > g->deg[v] || 2 * w > g->deg[u]))
+          pmc_pair (p, id, v, u);
+      }
+  for (s = lo; s < hi; ++s)
+    {
+      if (p->scanned[s])
+        continue;
+      heap_insert (q, s, 0);
+      while (heap_count (q) > 0)
+        {
+          v = heap_pop (q);
+          p->scanned[v] = 1;
+          for (a = g->start[v]; a < g->start[v+1]; ++a)
+            {
+              u = g->nbr[a];
+              if (u < lo || u >= hi || p->scanned[u])
+                continue;
+              if (heap_contains (q, u))
+                heap_raise (q, u, g->wt[a]);
+              else
+                heap_insert (q, u, g->wt[a]);
+              if (heap_key (q, u) >= best)
+                pmc_pair (p, id, v, u);
+            }
+        }
+    }
+}
+
+
+/**
+   One sweep of label propagation over block. Each node takes the label
+   most heavily connected to it, labels of nodes of the block are
+   updated in place, the others are read from the previous sweep.
+   @param p state
+   @param id index of worker
+*/
+static
+void
+pmc_propagate (pmc_t * p, unsigned id)
+{
+  const cgraph_t * g = p->work;
+  const unsigned lo = p->bound[id], hi = p->bound[id+1];
+  long long * acc = p->acc[id];
+  unsigned * touched = p->touched[id];
+  unsigned v, u, l, i, count;
+  size_t a;
+
+  for (v = lo; v < hi; ++v)
+    {
+      unsigned bestl = p->label[v];
+      long long bestw;
+
+      count = 0;
+      for (a = g->start[v]; a < g->start[v+1]; ++a)
+        {
+          u = g->nbr[a];
+          l = u >= lo && u < hi ? p->label[u] : p->old[u];
+          if (acc[l] == 0)
+            touched[count++] = l;
+          acc[l] += g->wt[a];
+        }
+      bestw = acc[bestl];
+      for (i = 0; i < count; ++i)
+        {
+          l = touched[i];
+          if (acc[l] > bestw || (acc[l] == bestw && l < bestl))
+            {
+              bestl = l;
+              bestw = acc[l];
+            }
+          acc[l] = 0;
+        }
+      p->label[v] = bestl;
+    }
+}
+
+
+static
+void *
+pmc_worker (void * arg)
+{
+  pmc_job_t * job = arg;
+
+  job->fn (job->p, job->id);
+  return NULL;
+}
+
+
+/**
+   Runs function on all blocks in parallel, the calling thread takes
+   the first block. Blocks whose thread cannot be started are run by the
+   calling thread too.
+   @param p state
+   @param fn work of one block
+   @return true on success, false on allocation failure of a worker
+*/
+static
+int
+pmc_run (pmc_t * p, void (* fn) (pmc_t *, unsigned))
+{
+  unsigned i;
+
+  for (i = 1; i < p->workers; ++i)
+    {
+      p->job[i].p = p;
+      p->job[i].id = i;
+      p->job[i].fn = fn;
+      p->started[i] = pthread_create (&p->tid[i], NULL, pmc_worker,
+                                      &p->job[i]) == 0;
+    }
+  fn (p, 0);
+  for (i = 1; i < p->workers; ++i)
+    if (p->started[i])
+      pthread_join (p->tid[i], NULL);
+    else
+      fn (p, i);
+  for (i = 0; i < p->workers; ++i)
+    if (p->failed[i])
+      return 0;
+  return 1;
+}
+
+
+/**
+   Renumbers groups given by labels or disjoint sets to 0 ... k-1 in
+   order of their lowest nodes.
+   @param n number of nodes
+   @param rep rep[v] is any node of the group of v, it is overwritten
+   @param to the new numbers of groups of nodes
+   @return number of groups
+*/
+static
+unsigned
+pmc_renumber (unsigned n, unsigned * rep, unsigned * to)
+{
+  unsigned v, k = 0;
+
+  for (v = 0; v < n; ++v)
+    to[v] = PMC_NONE;
+  for (v = 0; v < n; ++v)
+    if (to[rep[v]] == PMC_NONE)
+      to[rep[v]] = k++;
+  for (v = 0; v < n; ++v)
+    rep[v] = to[rep[v]];
+  memcpy (to, rep, n * sizeof (unsigned));
+  return k;
+}
+
+
+/**
+   Finds upper bound on the minimum cut as in inexact VieCut. Clusters
+   found by label propagation are contracted level by level on a copy
+   of the graph, every contracted node is a candidate side of a cut.
+   @param p state
+   @return true on success, false on allocation failure
+*/
+static
+int
+pmc_bound (pmc_t * p)
+{
+  cgraph_t * g = p->g, * h;
+  unsigned * cgroup, * to;
+  unsigned level, sweep, v, k, x;
+  int ret = 1;
+
+  cgroup = malloc (p->n0 * sizeof (unsigned));
+  to = malloc (p->n0 * sizeof (unsigned));
+  if (! cgroup || ! to)
+    {
+      free (cgroup);
+      free (to);
+      return 0;
+    }
+  memcpy (cgroup, p->group, p->n0 * sizeof (unsigned));
+  for (level = 0; level < PMC_LEVELS && g->n > 2; ++level)
+    {
+      pmc_blocks (p, g, p->threads);
+      for (v = 0; v < g->n; ++v)
+        p->label[v] = v;
+      for (sweep = 0; sweep < PMC_SWEEPS; ++sweep)
+        {
+          memcpy (p->old, p->label, g->n * sizeof (unsigned));
+          pmc_run (p, pmc_propagate);
+        }
+      k = pmc_renumber (g->n, p->label, to);
+      if (k == g->n)
+        break;
+      h = cgraph_contract (g, to, k);
+      if (! h)
+        {
+          ret = 0;
+          break;
+        }
+      for (x = 0; x < p->n0; ++x)
+        cgroup[x] = to[cgroup[x]];
+      if (g != p->g)
+        cgraph_delete (g);
+      g = h;
+      pmc_record (p, g, cgroup);
+    }
+  if (g != p->g)
+    cgraph_delete (g);
+  free (cgroup);
+  free (to);
+  return ret;
+}
+
+
+/**
+   Contracts all pairs found by workers.
+   @param p state
+   @return true on success, false on allocation failure
+*/
+static
+int
+pmc_contract (pmc_t * p)
+{
+  cgraph_t * h;
+  unsigned * parent, * to;
+  unsigned i, v, k, x;
+  size_t j;
+
+  parent = malloc (p->g->n * sizeof (unsigned));
+  to = malloc (p->g->n * sizeof (unsigned));
+  if (! parent || ! to)
+    {
+      free (parent);
+      free (to);
+      return 0;
+    }
+  for (v = 0; v < p->g->n; ++v)
+    parent[v] = v;
+  for (i = 0; i < p->workers; ++i)
+    for (j = 0; j < p->pairs[i]; ++j)
+      {
+        const unsigned a = pmc_find (parent, p->pair[i][2*j]);
+        const unsigned b = pmc_find (parent, p->pair[i][2*j+1]);
+
+        if (a != b)
+          parent[a < b ? b : a] = a < b ? a : b;
+      }
+  for (v = 0; v < p->g->n; ++v)
+    parent[v] = pmc_find (parent, v);
+  k = pmc_renumber (p->g->n, parent, to);
+  h = cgraph_contract (p->g, to, k);
+  if (h)
+    {
+      for (x = 0; x < p->n0; ++x)
+        p->group[x] = to[p->group[x]];
+      cgraph_delete (p->g);
+      p->g = h;
+    }
+  free (parent);
+  free (to);
+  return h != NULL;
+}
+
+
+static
+void
+pmc_free (pmc_t * p)
+{
+  unsigned i;
+
+  for (i = 0; i < p->threads; ++i)
+    {
+      if (p->queue && p->queue[i])
+        heap_delete (p->queue[i]);
+      if (p->acc)
+        free (p->acc[i]);
+      if (p->touched)
+        free (p->touched[i]);
+      if (p->pair)
+        free (p->pair[i]);
+    }
+  free (p->queue);
+  free (p->acc);
+  free (p->touched);
+  free (p->pair);
+  free (p->pairs);
+  free (p->pairmax);
+  free (p->failed);
+  free (p->bound);
+  free (p->scanned);
+  free (p->label);
+  free (p->old);
+  free (p->group);
+  free (p->tid);
+  free (p->job);
+  free (p->started);
+  if (p->g)
+    cgraph_delete (p->g);
+}
+
+
+/**
+   Finds minimum cut of positive weight with worker threads, in the
+   style of exact VieCut. An upper bound is found by label propagation
+   first. Then each round contracts edges found safe by pmc_scan() in
+   blocks of the graph and checks trivial cuts of the contracted nodes,
+   until no edges are left. When the blocks find nothing, the round is
+   repeated with a single block, whose maximum adjacency order always
+   contracts an edge. Edges of zero weight are ignored.
+   @param g graph
+   @param threads number of worker threads
+   @param side bitmap of at least csr_nodes(g) bits, set to one side of
+   the cut
+   @param weight weight of the cut, LLONG_MAX when the graph has no
+   edges and side is empty
+   @return true on success, false on allocation failure
+*/
+int
+pmc_mincut (const csr_t * g, unsigned threads, bitmap_t * side,
+            long long * weight)
+{
+  pmc_t p;
+  const unsigned n = csr_nodes (g);
+  unsigned i, x;
+  size_t found;
+  int ok = 1;
+
+  if (bitmap_size (side) < n || threads == 0)
+    abort ();
+  memset (&p, 0, sizeof (p));
+  p.threads = threads;
+  p.n0 = n;
+  p.side = side;
+  p.best = LLONG_MAX;
+  p.g = cgraph_from_csr (g);
+  p.group = malloc (n * sizeof (unsigned));
+  p.bound = malloc ((threads + 1) * sizeof (unsigned));
+  p.scanned = malloc (n);
+  p.label = malloc (n * sizeof (unsigned));
+  p.old = malloc (n * sizeof (unsigned));
+  p.queue = calloc (threads, sizeof (heap_t *));
+  p.acc = calloc (threads, sizeof (long long *));
+  p.touched = calloc (threads, sizeof (unsigned *));
+  p.pair = calloc (threads, sizeof (unsigned *));
+  p.pairs = calloc (threads, sizeof (size_t));
+  p.pairmax = calloc (threads, sizeof (size_t));
+  p.failed = calloc (threads, sizeof (int));
+  p.tid = malloc (threads * sizeof (pthread_t));
+  p.job = malloc (threads * sizeof (pmc_job_t));
+  p.started = malloc (threads * sizeof (int));
+  if (! p.g || ! p.group || ! p.bound || ! p.scanned || ! p.label
+      || ! p.old || ! p.queue || ! p.acc || ! p.touched || ! p.pair
+      || ! p.pairs || ! p.pairmax || ! p.failed || ! p.tid || ! p.job
+      || ! p.started)
+    ok = 0;
+  for (i = 0; ok && i < threads; ++i)
+    {
+      p.queue[i] = heap_new (n);
+      p.acc[i] = calloc (n, sizeof (long long));
+      p.touched[i] = malloc (n * sizeof (unsigned));
+      if (! p.queue[i] || ! p.acc[i] || ! p.touched[i])
+        ok = 0;
+    }
+  if (! ok)
+    {
+      pmc_free (&p);
+      return 0;
+    }
+
+  for (x = 0; x < n; ++x)
+    p.group[x] = x;
+  bitmap_clear (side);
+  pmc_record (&p, p.g, p.group);
+  if (! pmc_bound (&p))
+    ok = 0;
+  while (ok && cgraph_edges (p.g) > 0)
+    {
+      pmc_blocks (&p, p.g, threads);
+      memset (p.scanned, 0, p.g->n);
+      ok = pmc_run (&p, pmc_scan);
+      for (i = 0, found = 0; i < p.workers; ++i)
+        found += p.pairs[i];
+      if (ok && found == 0 && p.workers > 1)
+        {
+          pmc_blocks (&p, p.g, 1);
+          memset (p.scanned, 0, p.g->n);
+          ok = pmc_run (&p, pmc_scan);
+          found = p.pairs[0];
+        }
+      if (ok && found == 0)
+        abort ();
+      if (ok)
+        ok = pmc_contract (&p);
+      if (ok)
+        pmc_record (&p, p.g, p.group);
+    }
+  *weight = p.best;
+  pmc_free (&p);
+  return ok;
+}
@@ -0,0 +1,235 @@
+/*
+Copyright (c) 1997-2007, Václav Haisman
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "cgraph.h"
+#include "cgraph_priv.h"
+#include "reduce.h"
+
+
+/* Test of two-edge paths is run only for edges whose other end has at
+   most this many neighbours, it scans the whole row of that end. */
+#define REDUCE_PATHS_MAX 256
+
+/* No node. */
+#define REDUCE_NONE UINT_MAX
+
+
+static
+unsigned
+reduce_find (unsigned * parent, unsigned x)
+{
+  while (parent[x] != x)
+    {
+      parent[x] = parent[parent[x]];
+      x = parent[x];
+    }
+  return x;
+}
+
+
+/**
+   Makes the lightest trivial cut of graph the best one if it is
+   lighter. Nodes without edges are skipped, they make no cut of
+   positive weight.
+   @param g graph
+   @param n0 number of original nodes
+   @param group node of g containing each original node
+   @param side side of the best cut over original nodes
+   @param best weight of the best cut
+*/
+static
+void
+reduce_record (const cgraph_t * g, unsigned n0, const unsigned * group,
+               bitmap_t * side, long long * best)
+{
+  unsigned v, x, min = REDUCE_NONE;
+
+  for (v = 0; v < g->n; ++v)
+    if (g->deg[v] > 0 && g->deg[v] < *best
+        && (min == REDUCE_NONE || g->deg[v] < g->deg[min]))
+      min = v;
+  if (min == REDUCE_NONE)
+    return;
+  *best = g->deg[min];
+  bitmap_clear (side);
+  for (x = 0; x < n0; ++x)
+    if (group[x] == min)
+      bitmap_setbit (side, x);
+}
+
+
+/**
+   Joins ends of edges safe to contract into the same sets. An edge
+   {v,u} of weight w is safe when any cut crossing it is at least as
+   heavy as the best cut, or can be made lighter:
+   1. w >= best,
+   2. 2w > deg(v) or 2w > deg(u), moving the node to the other side
+      makes the cut lighter,
+   3. w plus sum of min(w(v,x), w(u,x)) over common neighbours x is
+      at least best, these are weights of disjoint paths from v to u.
+   All safe edges can be contracted together, the minimum cut crosses
+   none of them.
+   @param g graph
+   @param parent disjoint sets of nodes, initially singletons
+   @param mark scratch of g->n zeros, zeros again on return
+   @param best weight of the best cut
+   @return number of joined pairs of sets
+*/
+static
+unsigned
+reduce_mark (const cgraph_t * g, unsigned * parent, long long * mark,
+             long long best)
+{
+  unsigned v, u, found = 0;
+  size_t a, b;
+
+  for (v = 0; v < g->n; ++v)
+    {
+      for (a = g->start[v]; a < g->start[v+1]; ++a)
+        mark[g->nbr[a]] = g->wt[a];
+      for (a = g->start[v]; a < g->start[v+1]; ++a)
+        {
+          const long long w = g->wt[a];
+          int safe;
+
+          u = g->nbr[a];
+          /* Each edge is tested once, from its lower end. */
+          if (u < v)
+            continue;
+          safe = w >= best || 2 * w > g->deg[v] || 2 * w > g->deg[u];
+          /* The paths weigh at most the degree of either end. */
+          if (! safe && g->deg[v] >= best && g->deg[u] >= best
+              && g->start[u+1] - g->start[u] <= REDUCE_PATHS_MAX)
+            {
+              long long paths = w;
+
+              for (b = g->start[u]; b < g->start[u+1] && paths < best; ++b)
+                if (mark[g->nbr[b]] > 0)
+                  paths += mark[g->nbr[b]] < g->wt[b]
+                    ? mark[g->nbr[b]] : g->wt[b];
+              safe = paths >= best;
+            }
+          if (safe)
+            {
+              const unsigned x = reduce_find (parent, v);
+              const unsigned y = reduce_find (parent, u);
+
+              if (x != y)
+                {
+                  parent[x < y ? y : x] = x < y ? x : y;
+                  ++found;
+                }
+            }
+        }
+      for (a = g->start[v]; a < g->start[v+1]; ++a)
+        mark[g->nbr[a]] = 0;
+    }
+  return found;
+}
+
+
+/**
+   Reduces graph to a kernel whose minimum cut is the minimum cut of the
+   graph unless the lightest trivial cut seen on the way is at least as
+   light. Rounds of contractions of safe edges are repeated until no
+   edge is safe, each round checks trivial cuts of the contracted
+   nodes, which lowers the bound of the next one. Edges of zero weight
+   are ignored. Weights of edges of the kernel are below the returned
+   weight.
+   @param g graph
+   @param group array of csr_nodes(g) entries, group[x-1] is set to the
+   node of the kernel containing node x
+   @param side bitmap of at least csr_nodes(g) bits, set to side of the
+   lightest trivial cut
+   @param weight weight of the lightest trivial cut, LLONG_MAX when the
+   graph has no edges and side is empty
+   @return kernel or NULL on allocation failure
+*/
+csr_t *
+reduce_graph (const csr_t * g, unsigned * group, bitmap_t * side,
+              long long * weight)
+{
+  const unsigned n = csr_nodes (g);
+  cgraph_t * cg, * h;
+  csr_t * kernel = NULL;
+  unsigned * parent, * to;
+  long long * mark;
+  unsigned v, k, x;
+  int ok = 1;
+
+  if (bitmap_size (side) < n)
+    abort ();
+  cg = cgraph_from_csr (g);
+  parent = malloc (n * sizeof (unsigned));
+  to = malloc (n * sizeof (unsigned));
+  mark = calloc (n, sizeof (long long));
+  if (! cg || ! parent || ! to || ! mark)
+    ok = 0;
+
+  for (x = 0; ok && x < n; ++x)
+    group[x] = x;
+  *weight = LLONG_MAX;
+  bitmap_clear (side);
+  if (ok)
+    reduce_record (cg, n, group, side, weight);
+  while (ok)
+    {
+      for (v = 0; v < cg->n; ++v)
+        parent[v] = v;
+      if (reduce_mark (cg, parent, mark, *weight) == 0)
+        break;
+      /* Number the sets in order of their lowest nodes. */
+      for (v = 0, k = 0; v < cg->n; ++v)
+        {
+          parent[v] = reduce_find (parent, v);
+          to[v] = parent[v] == v ? k++ : to[parent[v]];
+        }
+      h = cgraph_contract (cg, to, k);
+      if (! h)
+        {
+          ok = 0;
+          break;
+        }
+      cgraph_delete (cg);
+      cg = h;
+      for (x = 0; x < n; ++x)
+        group[x] = to[group[x]];
+      reduce_record (cg, n, group, side, weight);
+    }
+  if (ok)
+    kernel = cgraph_to_csr (cg);
+  for (x = 0; kernel && x < n; ++x)
+    ++group[x];
+  if (cg)
+    cgraph_delete (cg);
+  free (parent);
+  free (to);
+  free (mark);
+  return kernel;
+}
@@ -0,0 +1,306 @@
+/*
+Copyright (c) 1997-2007, Václav Haisman
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <stdlib.h>
+#include <limits.h>
+#include "heap.h"
+#include "sw.h"
+
+
+/* No arc. */
+#define SW_NIL ((size_t)-1)
+
+
+/* Arc of contracted graph. Arcs leaving nodes of one group are linked
+   into one list, head is the node the arc was read with. */
+struct _swarc_t
+{
+  unsigned head;
+  int wt;
+  size_t next;
+};
+typedef struct _swarc_t swarc_t;
+
+
+/* State of the algorithm, nodes are counted from 0 here. */
+struct _sw_t
+{
+  swarc_t * arc;
+  /* First and last arc of list of each group. */
+  size_t * first;
+  size_t * last;
+  /* Disjoint sets of contracted nodes. */
+  unsigned * parent;
+  unsigned * size;
+  /* Groups reached by the current phase and not added yet, keyed by
+     weight of their edges to the added ones. */
+  heap_t * queue;
+  /* Number of phase in which each node was reached last. */
+  unsigned long * stamp;
+  unsigned long phase;
+  /* Contractions done so far, merged[2*i] and merged[2*i+1] are the
+     groups joined by contraction i. */
+  unsigned * merged;
+  unsigned merges;
+};
+typedef struct _sw_t sw_t;
+
+
+static
+unsigned
+sw_find (unsigned * parent, unsigned x)
+{
+  while (parent[x] != x)
+    {
+      parent[x] = parent[parent[x]];
+      x = parent[x];
+    }
+  return x;
+}
+
+
+/**
+   Joins groups of two nodes.
+   @param parent disjoint sets
+   @param size sizes of the sets
+   @param x representative of one group
+   @param y representative of the other group
+   @return representative of the joined group
+*/
+static
+unsigned
+sw_union (unsigned * parent, unsigned * size, unsigned x, unsigned y)
+{
+  if (size[x] < size[y])
+    {
+      const unsigned t = x;
+
+      x = y;
+      y = t;
+    }
+  parent[y] = x;
+  size[x] += size[y];
+  return x;
+}
+
+
+/**
+   Runs one phase on the group of node a. Groups of its component are
+   added in order of the heaviest connection to the groups added before
+   them and the last two are contracted. The cut of the phase separates
+   the last group from the rest of the component.
+   @param s state
+   @param a representative of the first group
+   @param cut weight of the cut of the phase
+   @param t representative of the last group
+   @return number of groups of the component
+*/
+static
+unsigned
+sw_phase (sw_t * s, unsigned a, long long * cut, unsigned * t)
+{
+  unsigned v, u, prev = a, last = a, reached = 0;
+  size_t k, before;
+
+  ++s->phase;
+  s->stamp[a] = s->phase;
+  heap_insert (s->queue, a, 0);
+  while (heap_count (s->queue) > 0)
+    {
+      v = heap_pop (s->queue);
+      ++reached;
+      prev = last;
+      last = v;
+      *cut = heap_key (s->queue, v);
+      before = SW_NIL;
+      for (k = s->first[v]; k != SW_NIL; k = s->arc[k].next)
+        {
+          u = sw_find (s->parent, s->arc[k].head);
+          if (u == v)
+            {
+              /* Arc inside the group, drop it from the list. */
+              if (before == SW_NIL)
+                s->first[v] = s->arc[k].next;
+              else
+                s->arc[before].next = s->arc[k].next;
+              if (s->last[v] == k)
+                s->last[v] = before;
+              continue;
+            }
+          before = k;
+          if (s->stamp[u] != s->phase)
+            {
+              s->stamp[u] = s->phase;
+              heap_insert (s->queue, u, s->arc[k].wt);
+            }
+          else if (heap_contains (s->queue, u))
+            heap_raise (s->queue, u, s->arc[k].wt);
+        }
+    }
+  if (reached < 2)
+    return reached;
+  /* Contract the last group into the one before it. */
+  *t = last;
+  s->merged[2*s->merges] = prev;
+  s->merged[2*s->merges+1] = last;
+  ++s->merges;
+  v = sw_union (s->parent, s->size, prev, last);
+  u = v == prev ? last : prev;
+  if (s->first[u] != SW_NIL)
+    {
+      if (s->first[v] == SW_NIL)
+        s->first[v] = s->first[u];
+      else
+        s->arc[s->last[v]].next = s->first[u];
+      s->last[v] = s->last[u];
+    }
+  return reached;
+}
+
+
+static
+void
+sw_free (sw_t * s)
+{
+  free (s->arc);
+  free (s->first);
+  free (s->last);
+  free (s->parent);
+  free (s->size);
+  if (s->queue)
+    heap_delete (s->queue);
+  free (s->stamp);
+  free (s->merged);
+}
+
+
+/**
+   Finds minimum cut of positive weight. Each connected component is
+   contracted down to a single node by phases of the algorithm, the
+   lightest cut of a phase is the minimum cut of the component and the
+   lightest of those is the result. Each phase takes O(M log N) time
+   with binary heap, the whole run O(NM log N), memory is O(N + M).
+   Edges of zero weight are ignored.
+   @param g graph
+   @param side bitmap of at least csr_nodes(g) bits, set to one side of
+   the cut
+   @param weight weight of the cut, LLONG_MAX when the graph has no
+   edges and side is empty
+   @return true on success, false on allocation failure
+*/
+int
+sw_mincut (const csr_t * g, bitmap_t * side, long long * weight)
+{
+  sw_t s;
+  const unsigned n = csr_nodes (g);
+  const unsigned * nbr;
+  const int * wt;
+  unsigned x, y, r, t = 0, bestmerges = 0, bestnode = 0;
+  size_t m = 0;
+  long long cut, best = LLONG_MAX;
+  char * finished;
+
+  if (bitmap_size (side) < n)
+    abort ();
+  s.arc = malloc ((2 * csr_edges (g) + 1) * sizeof (swarc_t));
+  s.first = malloc (n * sizeof (size_t));
+  s.last = malloc (n * sizeof (size_t));
+  s.parent = malloc (n * sizeof (unsigned));
+  s.size = malloc (n * sizeof (unsigned));
+  s.queue = heap_new (n);
+  s.stamp = calloc (n, sizeof (unsigned long));
+  s.merged = malloc (2 * n * sizeof (unsigned));
+  finished = calloc (n, 1);
+  if (! s.arc || ! s.first || ! s.last || ! s.parent || ! s.size
+      || ! s.queue || ! s.stamp || ! s.merged
+      || ! finished)
+    {
+      sw_free (&s);
+      free (finished);
+      return 0;
+    }
+  s.phase = 0;
+  s.merges = 0;
+  for (x = 0; x < n; ++x)
+    {
+      const unsigned deg = csr_row (g, x + 1, &nbr, &wt);
+
+      s.parent[x] = x;
+      s.size[x] = 1;
+      s.first[x] = SW_NIL;
+      s.last[x] = SW_NIL;
+      for (y = 0; y < deg; ++y)
+        if (wt[y] > 0)
+          {
+            s.arc[m].head = nbr[y] - 1;
+            s.arc[m].wt = wt[y];
+            s.arc[m].next = SW_NIL;
+            if (s.first[x] == SW_NIL)
+              s.first[x] = m;
+            else
+              s.arc[s.last[x]].next = m;
+            s.last[x] = m++;
+          }
+    }
+
+  /* Contract components one by one. */
+  for (x = 0; x < n; ++x)
+    {
+      if (finished[sw_find (s.parent, x)])
+        continue;
+      while (sw_phase (&s, sw_find (s.parent, x), &cut, &t) > 1)
+        if (cut < best)
+          {
+            best = cut;
+            bestmerges = s.merges - 1;
+            bestnode = t;
+          }
+      finished[sw_find (s.parent, x)] = 1;
+    }
+
+  /* The side of the best cut is the group of its last node as it was
+     before the cut's phase, replay contractions up to that phase. */
+  bitmap_clear (side);
+  if (best != LLONG_MAX)
+    {
+      for (x = 0; x < n; ++x)
+        {
+          s.parent[x] = x;
+          s.size[x] = 1;
+        }
+      for (x = 0; x < bestmerges; ++x)
+        sw_union (s.parent, s.size, sw_find (s.parent, s.merged[2*x]),
+                  sw_find (s.parent, s.merged[2*x+1]));
+      r = sw_find (s.parent, bestnode);
+      for (x = 0; x < n; ++x)
+        if (sw_find (s.parent, x) == r)
+          bitmap_setbit (side, x);
+    }
+  *weight = best;
+  sw_free (&s);
+  free (finished);
+  return 1;
+}
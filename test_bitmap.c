@@ -25,12 +25,18 @@ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 #include <stdlib.h>
+#include <stdio.h>
 #include <time.h>
+#include <mpi.h>
 #include "bitmap.h"
 
-int main (void)
+int main (int argc, char * argv[])
 {
-  bitmap_t * bm = bitmap_new (33);
+  bitmap_t * bm;
+
+  /* bitmap_serialize() and bitmap_deserialize() use MPI_Pack(). */
+  MPI_Init (&argc, &argv);
+  bm = bitmap_new (33);
   if (! bm)
     abort ();
 
@@ -115,23 +121,88 @@ int main (void)
     printf ("\n");
   }
 
+  /* Check bulk operations and iteration. */
+  {
+    bitmap_t * a = bitmap_new (150), * b = bitmap_new (150), * c;
+    bitmap_iter_t it;
+    unsigned i, pos, count = 0, both = 0;
+
+    if (! a || ! b)
+      abort ();
+    for (i = 0; i < bitmap_size (a); ++i)
+      {
+        bitmap_putbit (a, i, random () % 2);
+        bitmap_putbit (b, i, random () % 2);
+        count += bitmap_getbit (a, i);
+        both += bitmap_getbit (a, i) && bitmap_getbit (b, i);
+      }
+    if (bitmap_count (a) != count || bitmap_count_and (a, b) != both)
+      abort ();
+
+    c = bitmap_clone (a);
+    bitmap_and (c, b);
+    if (bitmap_count (c) != both)
+      abort ();
+    bitmap_or (bitmap_copy (c, a), b);
+    for (i = 0; i < bitmap_size (c); ++i)
+      if (bitmap_getbit (c, i) 
+          != (bitmap_getbit (a, i) || bitmap_getbit (b, i)))
+        abort ();
+    bitmap_xor (bitmap_copy (c, a), b);
+    for (i = 0; i < bitmap_size (c); ++i)
+      if (bitmap_getbit (c, i) 
+          != (bitmap_getbit (a, i) ^ bitmap_getbit (b, i)))
+        abort ();
+    bitmap_andnot (bitmap_copy (c, a), b);
+    if (bitmap_count (c) != count - both)
+      abort ();
+
+    /* Iterator and bitmap_next() visit the same bits as bitmap_getbit(). */
+    i = bitmap_first (a);
+    bitmap_iter_init (&it, a);
+    while (bitmap_iter_next (&it, &pos))
+      {
+        if (pos != i || ! bitmap_getbit (a, pos))
+          abort ();
+        i = bitmap_next (a, pos + 1);
+      }
+    if (i != bitmap_size (a))
+      abort ();
+    bitmap_clear (a);
+    if (bitmap_first (a) != bitmap_size (a))
+      abort ();
+
+    bitmap_delete (a);
+    bitmap_delete (b);
+    bitmap_delete (c);
+  }
+
   /* Check serialization. */
   {
     bitmap_t * copy;
     void * buf;
-    size_t sz = bitmap_serialize_size (bm),
-      size, pos = 0;
+    unsigned i;
+    size_t sz = bitmap_serialize_size (bm), pos = 0;
     buf = malloc (sz);
-    if (! sz)
+    if (! buf)
+      abort ();
+    bitmap_serialize (buf, sz, &pos, bm);
+    if (pos > sz)
       abort ();
-    bitmap_serialize (buf, &size, &pos, bm);
     pos = 0;
-    copy = bitmap_deserialize (buf, &pos);
+    copy = bitmap_deserialize (buf, sz, &pos);
+    if (! copy || bitmap_size (copy) != bitmap_size (bm))
+      abort ();
+    for (i = 0; i < bitmap_size (bm); ++i)
+      if (bitmap_getbit (copy, i) != bitmap_getbit (bm, i))
+        abort ();
     bitmap_print (copy, stdout, " ");
     printf ("\n");
     bitmap_delete (copy);
+    free (buf);
   }
 
   bitmap_delete (bm);
+  MPI_Finalize ();
   return 0;
 }
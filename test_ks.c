@@ -0,0 +1,94 @@
+/*
+Copyright (c) 1997-2007, Václav Haisman
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include "bitmap.h"
+#include "csr.h"
+#include "ks.h"
+
+/* Nodes in a community. */
+#define SIZE 4
+
+int main (void)
+{
+  unsigned k;
+
+  /* Communities with interleaved node numbers, node x belongs to
+     community (x - 1) % k. Each is complete with edges of weight
+     k - c, so the minimum cut cuts off one node of the last one. */
+  for (k = 2; k <= 5; ++k)
+    {
+      const unsigned n = k * SIZE;
+      unsigned * ends = malloc (n * (SIZE - 1) * sizeof (unsigned));
+      int * wt = malloc (n * (SIZE - 1) / 2 * sizeof (int));
+      bitmap_t * side = bitmap_new (n);
+      csr_t * g;
+      size_t m = 0, i;
+      unsigned x, y, c, count = 0;
+      long long weight, cut = 0;
+
+      if (! ends || ! wt || ! side)
+        abort ();
+      for (x = 1; x <= n; ++x)
+        for (y = x + k; y <= n; y += k)
+          {
+            ends[2*m] = x;
+            ends[2*m+1] = y;
+            wt[m++] = k - (x - 1) % k;
+          }
+      g = csr_from_edges (n, m, ends, wt);
+      if (! g || ! ks_mincut (g, 1e-6, 1, 0, 1, side, &weight))
+        abort ();
+
+      /* The side lies in one community and the cut is as reported. */
+      c = bitmap_first (side);
+      if (c == bitmap_size (side))
+        abort ();
+      c %= k;
+      for (x = 0; x < n; ++x)
+        if (bitmap_getbit (side, x))
+          {
+            if (x % k != c)
+              abort ();
+            ++count;
+          }
+      for (i = 0; i < m; ++i)
+        if (bitmap_getbit (side, ends[2*i] - 1)
+            != bitmap_getbit (side, ends[2*i+1] - 1))
+          cut += wt[i];
+      printf ("%u communities: weight %lld, cut %lld\n", k, weight, cut);
+      if (cut != weight || weight != SIZE - 1 || c != k - 1
+          || (count != 1 && count != SIZE - 1))
+        abort ();
+
+      csr_delete (g);
+      bitmap_delete (side);
+      free (ends);
+      free (wt);
+    }
+  return 0;
+}
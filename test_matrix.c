@@ -0,0 +1,79 @@
+/*
+Copyright (c) 1997-2007, Václav Haisman
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include "matrix.h"
+
+/* Edge size of the test matrix. */
+#define SIZE 7
+
+int main (void)
+{
+  /* Values that need each width in turn. */
+  const wvalue_t vals[] = {200, 60000, 4000000000u,
+                           ((wvalue_t)1 << 40) + 3};
+  const unsigned widths[] = {1, 2, 4, 8};
+  unsigned pos[SIZE], i, x, y;
+  wtrimatrix_t * mx = wtrimatrix_new (SIZE), * perm;
+
+  if (! mx || wtrimatrix_width (mx) != 1)
+    abort ();
+
+  /* Value i goes to element (i + 1, i + 2), widening keeps the earlier
+     ones. */
+  for (i = 0; i < 4; ++i)
+    {
+      if (! wtrimatrix_fit (mx, vals[i])
+          || wtrimatrix_width (mx) != widths[i])
+        abort ();
+      wtrimatrix_set (mx, i + 1, i + 2, vals[i]);
+      for (x = 0; x <= i; ++x)
+        if (wtrimatrix_get (mx, x + 1, x + 2) != vals[x]
+            || wtrimatrix_get (mx, x + 2, x + 1) != vals[x])
+          abort ();
+    }
+  /* Narrower values do not narrow the matrix. */
+  if (! wtrimatrix_fit (mx, 1) || wtrimatrix_width (mx) != 8)
+    abort ();
+  printf ("widths 1, 2, 4 and 8 bytes hold their values\n");
+
+  /* Relabelling keeps both the values and the width. */
+  for (x = 0; x < SIZE; ++x)
+    pos[x] = SIZE - x;
+  perm = wtrimatrix_permute (mx, pos);
+  if (! perm || wtrimatrix_width (perm) != 8)
+    abort ();
+  for (x = 1; x <= SIZE; ++x)
+    for (y = 1; y <= SIZE; ++y)
+      if (wtrimatrix_get (perm, pos[x-1], pos[y-1])
+          != wtrimatrix_get (mx, x, y))
+        abort ();
+
+  wtrimatrix_delete (perm);
+  wtrimatrix_delete (mx);
+  return 0;
+}
@@ -0,0 +1,140 @@
+/*
+Copyright (c) 1997-2007, Václav Haisman
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/* The program is built around its globals, the test drives it from
+   the inside. */
+#define main mrg_main
+#include "mrg.c"
+#undef main
+
+/* Nodes of the test graph. */
+#define NODES 9
+
+
+/**
+   Asks this process for work and reads its answer.
+   @return number of stack elements given away, -1 if denied
+*/
+static int
+ask_self (void)
+{
+  void * buf = malloc (recv_buf_len);
+  int given = 0, ret;
+  size_t pos;
+  char type;
+
+  if (! buf)
+    abort ();
+  wouldgive = 1;
+  process_work_request (rank);
+  while (1)
+    {
+      ret = MPI_Recv (buf, recv_buf_len, MPI_PACKED, rank, MPI_ANY_TAG,
+                      MPI_COMM_WORLD, &status);
+      if (ret != MPI_SUCCESS)
+        mpierror (ret, "MPI_Recv()");
+      pos = 0;
+      type = unpack_char (buf, recv_buf_len, &pos);
+      if (type == TYPE_STKELEM)
+        {
+          ++given;
+          continue;
+        }
+      if (type != TYPE_MSG)
+        abort ();
+      type = unpack_char (buf, recv_buf_len, &pos);
+      free (buf);
+      if (type == MSG_DENY)
+        return -1;
+      if (type != MSG_EOE)
+        abort ();
+      return given;
+    }
+}
+
+
+int main (int argc, char * argv[])
+{
+  unsigned ends[2 * NODES], x;
+  int wt[NODES], open = 0, exhausted = 0;
+
+  initialize_mpi (&argc, &argv, &rank, &worldsize);
+  /* Weighted cycle, its lightest cuts are far from the first ones. */
+  N = NODES;
+  for (x = 0; x < N; ++x)
+    {
+      ends[2*x] = x + 1;
+      ends[2*x+1] = (x + 1) % N + 1;
+      wt[x] = 5 + x % 3;
+    }
+  adj = csr_from_edges (N, N, ends, wt);
+  stack = deque_new ();
+  if (! adj || ! stack)
+    abort ();
+  useundo = 1;
+  kernel_init ();
+  initialize ();
+
+  /* Requests for work arrive while the stack is empty and the undo
+     log is at any depth. The leaf kernel leaves the bottom level with
+     no child left, without it the levels are walked one by one. */
+  for (leafbits = LEAF_MAX; ; leafbits = 0)
+    {
+      /* initialize() has put the root for the first walk. */
+      if (deque_size (stack) == 0)
+        initialize_stack ();
+      best->weight = WEIGHT_MAX;
+      undo_load (deque_pop (stack));
+      while (undodepth > 0)
+        {
+          if (deque_size (stack) != 0)
+            abort ();
+          if (undo_bottom_open ())
+            {
+              if (ask_self () < 0)
+                abort ();
+              ++open;
+            }
+          else if (ask_self () >= 0)
+            abort ();
+          else
+            ++exhausted;
+          /* Elements given away are gone, the working set goes on. */
+          undo_step ();
+        }
+      if (ask_self () >= 0)
+        abort ();
+      if (leafbits == 0)
+        break;
+    }
+  printf ("%d requests served, %d denied on exhausted bottom level\n",
+          open, exhausted);
+  if (! open || ! exhausted)
+    abort ();
+
+  MPI_Finalize ();
+  return 0;
+}